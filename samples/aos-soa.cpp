@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// The std-simd squaring and a length kernel (w = x*x + y*y + z*z) on uflat::vector4uc32
+// data in AoS, SoA and AoSoA layout (see layout.hpp).
+//
+//	aos-soa --size=16777216 --warmup=2 --repeat=10 --format=csv
+//
+// --size is the number of u32 lanes, so there are size/4 vectors. The SoA and AoSoA
+// kernels load one native_simd of a single component at a time.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/flat.hpp>
+#include <experimental/simd>
+#include "bench.hpp"
+#include "layout.hpp"
+
+namespace stdx = std::experimental;
+namespace layout = samples::layout;
+
+using position_t = uflat::vector4uc32;
+using position_simd = stdx::native_simd<utx::u32>;
+using lane_t = layout::lane_t<position_t>;
+constexpr std::size_t width = position_simd::size();
+constexpr std::size_t components = layout::components_v<position_t>;
+
+static_assert(std::is_same_v<lane_t, utx::u32>);
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+
+	// a multiple of width, so every soa component starts on a simd boundary
+	const std::size_t n = samples::round_up(std::max<std::size_t>(opts.size/components, 1), width);
+	const double bytes = n*sizeof(position_t);
+
+	std::vector<position_t> map(n), aos_result(n), soa_result(n), aosoa_result(n);
+	for (std::size_t i=0; i<n; i++)
+		for (std::size_t c=0; c<components; c++)
+			map[i][c] = (i*components+c)%1000 + 1;
+
+	sycl::buffer<position_t, 1> aos{sycl::range<1>{n}};
+	sycl::buffer<lane_t, 1> soa{sycl::range<1>{components*n}};
+	sycl::buffer<lane_t, 1> aosoa{sycl::range<1>{layout::aosoa_size<position_t>(n, width)}};
+
+	auto reset = [&]
+	{
+		queue.submit(
+			[&] (sycl::handler & handler)
+			{
+				auto acc = sycl::accessor{aos, handler, sycl::write_only, sycl::no_init};
+				handler.copy(map.data(), acc);
+			}
+		);
+		layout::aos_to_soa(queue, aos, soa);
+		layout::aos_to_aosoa(queue, aos, aosoa, width).wait();
+	};
+
+	// layout transforms
+	reset();
+	report(samples::bench::run(opts, "aos-to-soa", "vector4uc32", n, 2*bytes, 0,
+		[&] { return layout::aos_to_soa(queue, aos, soa); }));
+	report(samples::bench::run(opts, "soa-to-aos", "vector4uc32", n, 2*bytes, 0,
+		[&] { return layout::soa_to_aos(queue, soa, aos); }));
+	report(samples::bench::run(opts, "aos-to-aosoa", "vector4uc32", n, 2*bytes, 0,
+		[&] { return layout::aos_to_aosoa(queue, aos, aosoa, width); }));
+	report(samples::bench::run(opts, "aosoa-to-aos", "vector4uc32", n, 2*bytes, 0,
+		[&] { return layout::aosoa_to_aos(queue, aosoa, aos, width); }));
+
+	// soa and aosoa converted back to aos must equal aos; aos is left holding the aosoa result
+	auto read_aos = [&] (std::vector<position_t> & host)
+	{
+		queue.submit(
+			[&] (sycl::handler & handler)
+			{
+				auto acc = sycl::accessor{aos, handler, sycl::read_only};
+				handler.copy(acc, host.data());
+			}
+		).wait();
+	};
+	auto check = [&] (const char * name)
+	{
+		read_aos(aos_result);
+		layout::soa_to_aos(queue, soa, aos);
+		read_aos(soa_result);
+		layout::aosoa_to_aos(queue, aosoa, aos, width);
+		read_aos(aosoa_result);
+		for (std::size_t i=0; i<n; i++)
+			for (std::size_t c=0; c<components; c++)
+				if (samples::to_raw(soa_result[i][c]) != samples::to_raw(aos_result[i][c]) ||
+					samples::to_raw(aosoa_result[i][c]) != samples::to_raw(aos_result[i][c]))
+				{
+					utx::printe(name, "FAILED at", i, c);
+					return false;
+				}
+		return true;
+	};
+
+	// squaring, every component
+	reset();
+	if (!check("round-trip"))
+		return 1;
+	report(samples::bench::run(opts, "square-aos", "vector4uc32", n, 2*bytes, n*components,
+		[&]
+		{
+			return queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					auto acc = sycl::accessor{aos, handler, sycl::read_write};
+					handler.parallel_for<class square_aos>(
+						sycl::range<1>{n},
+						[=] (sycl::id<1> id)
+						{
+							position_t & pos = acc[id];
+							for (std::size_t c=0; c<components; c++)
+								pos[c] = pos[c]*pos[c];
+						}
+					);
+				}
+			);
+		}
+	));
+	auto square_lanes = [&] (sycl::buffer<lane_t, 1> & lanes)
+	{
+		return queue.submit(
+			[&] (sycl::handler & handler)
+			{
+				auto acc = sycl::accessor{lanes, handler, sycl::read_write};
+				handler.parallel_for<class square_lanes>(
+					sycl::range<1>{lanes.size()/width},
+					[=] (sycl::id<1> id)
+					{
+						lane_t * lane = &acc[id[0]*width];
+						position_simd simd;
+						simd.copy_from(lane, stdx::element_aligned);
+						simd *= simd;
+						simd.copy_to(lane, stdx::element_aligned);
+					}
+				);
+			}
+		);
+	};
+	report(samples::bench::run(opts, "square-soa", "vector4uc32", n, 2*bytes, n*components,
+		[&] { return square_lanes(soa); }));
+	report(samples::bench::run(opts, "square-aosoa", "vector4uc32", n, 2*bytes, n*components,
+		[&] { return square_lanes(aosoa); }));
+	// every layout was squared the same number of times since the reset
+	bool ok = check("square");
+
+	// length, one component out of three in
+	reset();
+	report(samples::bench::run(opts, "length-aos", "vector4uc32", n, bytes, 5.0*n,
+		[&]
+		{
+			return queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					auto acc = sycl::accessor{aos, handler, sycl::read_write};
+					handler.parallel_for<class length_aos>(
+						sycl::range<1>{n},
+						[=] (sycl::id<1> id)
+						{
+							position_t & pos = acc[id];
+							pos[3] = pos[0]*pos[0] + pos[1]*pos[1] + pos[2]*pos[2];
+						}
+					);
+				}
+			);
+		}
+	));
+	report(samples::bench::run(opts, "length-soa", "vector4uc32", n, bytes, 5.0*n,
+		[&]
+		{
+			return queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					auto acc = sycl::accessor{soa, handler, sycl::read_write};
+					handler.parallel_for<class length_soa>(
+						sycl::range<1>{n/width},
+						[=] (sycl::id<1> id)
+						{
+							const std::size_t base = id[0]*width;
+							position_simd x, y, z;
+							x.copy_from(&acc[0*n+base], stdx::element_aligned);
+							y.copy_from(&acc[1*n+base], stdx::element_aligned);
+							z.copy_from(&acc[2*n+base], stdx::element_aligned);
+							const position_simd w = x*x + y*y + z*z;
+							w.copy_to(&acc[3*n+base], stdx::element_aligned);
+						}
+					);
+				}
+			);
+		}
+	));
+	report(samples::bench::run(opts, "length-aosoa", "vector4uc32", n, bytes, 5.0*n,
+		[&]
+		{
+			return queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					auto acc = sycl::accessor{aosoa, handler, sycl::read_write};
+					handler.parallel_for<class length_aosoa>(
+						sycl::range<1>{n/width},
+						[=] (sycl::id<1> id)
+						{
+							const std::size_t base = id[0]*components*width;
+							position_simd x, y, z;
+							x.copy_from(&acc[base+0*width], stdx::element_aligned);
+							y.copy_from(&acc[base+1*width], stdx::element_aligned);
+							z.copy_from(&acc[base+2*width], stdx::element_aligned);
+							const position_simd w = x*x + y*y + z*z;
+							w.copy_to(&acc[base+3*width], stdx::element_aligned);
+						}
+					);
+				}
+			);
+		}
+	));
+	// the length kernels are idempotent, so all three layouts must agree now
+	ok = check("length") && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// One saxpy body on an extent that no work-group size divides (see launch.hpp).
+//
+//	arbitrary-size --size=10000000 --warmup=2 --repeat=10 --format=csv
+//
+// 3 elements are added to --size. The body runs through a plain range, masked and
+// grid-stride nd_range launches, and an nd_range with a local range of 1, which is all
+// that divides an odd size. The 2d runs use a 4099 column extent.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "launch.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+class range_saxpy_kernel;
+class local_one_saxpy_kernel;
+class masked_saxpy_kernel;
+class grid_stride_saxpy_kernel;
+class masked_saxpy_2d_kernel;
+class grid_stride_saxpy_2d_kernel;
+
+// y = a x + y
+struct saxpy
+{
+	utx::fc32 a;
+	const utx::fc32 * x;
+	utx::fc32 * y;
+
+	void operator()(sycl::id<1> id) const
+	{
+		y[id] = a*x[id] + y[id];
+	}
+};
+
+// the same on a row-major rows x cols extent
+struct saxpy_2d
+{
+	saxpy body;
+	std::size_t cols;
+
+	void operator()(sycl::id<2> id) const
+	{
+		body(sycl::id<1>{id[0]*cols + id[1]});
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t size = opts.size + 3;
+	const std::size_t cols = 4099, rows = size/cols;
+	auto x = samples::make_pooled<utx::fc32>(pool, size);
+	auto y = samples::make_pooled<utx::fc32>(pool, size);
+	std::vector<utx::fc32> host_x(size), host_y(size);
+	for (std::size_t i=0; i<size; i++)
+		host_x[i] = static_cast<float>(i%1000);
+
+	const saxpy body{2.0f, x.get(), y.get()};
+	const sycl::range<1> extent{size};
+	const sycl::range<2> extent_2d{rows, cols};
+	const double bytes = 3.0*size*sizeof(utx::fc32);
+
+	// y starts at 0 for every check, so one run leaves y = 2 x
+	auto check = [&] (const std::string & name, std::size_t count, auto submit)
+	{
+		queue.memset(y.get(), 0, size*sizeof(utx::fc32)).wait();
+		submit().wait();
+		queue.memcpy(host_y.data(), y.get(), size*sizeof(utx::fc32)).wait();
+		for (std::size_t i=0; i<size; i++)
+		{
+			const float want = i < count ? 2.0f*host_x[i]() : 0.0f;
+			if (host_y[i]() != want)
+			{
+				utx::printe(name, "FAILED at", i, host_y[i], "!=", want);
+				return false;
+			}
+		}
+		return true;
+	};
+	queue.memcpy(x.get(), host_x.data(), size*sizeof(utx::fc32)).wait();
+
+	bool ok = true;
+	auto bench = [&] (const std::string & name, std::size_t count, auto submit)
+	{
+		report(samples::bench::run(opts, name, "fc32", count, bytes*count/size, 2.0*count, submit));
+		ok = check(name, count, submit) && ok;
+	};
+
+	bench("range", size,
+		[&]
+		{
+			return queue.parallel_for<range_saxpy_kernel>(extent, body);
+		}
+	);
+	bench("local-1", size,
+		[&]
+		{
+			return queue.parallel_for<local_one_saxpy_kernel>(
+				sycl::nd_range<1>{extent, sycl::range<1>{1}},
+				[=] (sycl::nd_item<1> item)
+				{
+					body(item.get_global_id());
+				}
+			);
+		}
+	);
+	bench("masked", size,
+		[&]
+		{
+			return samples::launch::masked<masked_saxpy_kernel>(queue, extent, body);
+		}
+	);
+	bench("grid-stride", size,
+		[&]
+		{
+			return samples::launch::grid_stride<grid_stride_saxpy_kernel>(queue, extent, body);
+		}
+	);
+	bench("masked-2d", rows*cols,
+		[&]
+		{
+			return samples::launch::masked<masked_saxpy_2d_kernel>(queue, extent_2d, saxpy_2d{body, cols});
+		}
+	);
+	bench("grid-stride-2d", rows*cols,
+		[&]
+		{
+			return samples::launch::grid_stride<grid_stride_saxpy_2d_kernel>(queue, extent_2d, saxpy_2d{body, cols});
+		}
+	);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Batched 4 x 4 and 8 x 8 matrix products in one launch (see batched-gemm.hpp).
+//
+//	batched-gemm --size=16777216 --warmup=2 --repeat=10 --format=csv
+//
+// --size is the number of elements per operand, so there are size/16 4 x 4 or size/64 8 x 8
+// matrices. gemm-per-matrix launches samples::gemm once per matrix for the first 1024
+// matrices only, as the matrix-mul sample would. The size of every result is its number of
+// matrices, so the items_per_s column of the report is matrices/s.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "batched-gemm.hpp"
+#include "bench.hpp"
+#include "gemm.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+template <std::size_t dim>
+bool run_batched(
+	sycl::queue & queue,
+	samples::usm_pool & pool,
+	const samples::bench::options & opts,
+	samples::bench::reporter & report
+)
+{
+	constexpr std::size_t entries = dim*dim;
+	const std::size_t batch = std::max<std::size_t>(opts.size/entries, 1);
+	const std::size_t size = batch*entries;
+	const std::string shape = std::to_string(dim) + "x" + std::to_string(dim);
+	const double flops = 2.0*dim*entries*batch;
+	const double bytes = 3.0*size*sizeof(utx::fc32);
+
+	std::vector<utx::fc32> host_a(size), host_b(size), host_c(size);
+	auto a = samples::make_pooled<utx::fc32>(pool, size);
+	auto b = samples::make_pooled<utx::fc32>(pool, size);
+	auto c = samples::make_pooled<utx::fc32>(pool, size);
+
+	bool ok = true;
+	for (auto kind: {samples::batch_layout::contiguous, samples::batch_layout::interleaved})
+	{
+		const samples::batch_layout layout{kind};
+		const std::string name = "batched-gemm-" + shape +
+			(kind == samples::batch_layout::contiguous ? "-contiguous" : "-interleaved");
+		auto at = [&] (std::size_t m, std::size_t e)
+		{
+			return kind == samples::batch_layout::contiguous ? m*entries + e : e*batch + m;
+		};
+
+		// matrix m is a small integer pattern, exact in fc32
+		for (std::size_t m=0; m<batch; m++)
+			for (std::size_t e=0; e<entries; e++)
+			{
+				host_a[at(m, e)] = static_cast<float>((m+e)%5) - 2.0f;
+				host_b[at(m, e)] = static_cast<float>((m*3+e)%7) - 3.0f;
+			}
+		queue.memcpy(a.get(), host_a.data(), size*sizeof(utx::fc32));
+		queue.memcpy(b.get(), host_b.data(), size*sizeof(utx::fc32)).wait();
+
+		report(samples::bench::run(opts, name, "fc32", batch, bytes, flops,
+			[&]
+			{
+				return samples::batched_gemm<dim>(queue, a.get(), b.get(), c.get(), batch, layout);
+			}
+		));
+
+		queue.memcpy(host_c.data(), c.get(), size*sizeof(utx::fc32)).wait();
+		for (std::size_t m=0; m<batch && ok; m+=batch/101+1)
+			for (std::size_t i=0; i<dim; i++)
+				for (std::size_t j=0; j<dim; j++)
+				{
+					float want = 0;
+					for (std::size_t p=0; p<dim; p++)
+						want += host_a[at(m, i*dim+p)]() * host_b[at(m, p*dim+j)]();
+					if (host_c[at(m, i*dim+j)]() != want)
+					{
+						utx::printe(name, "FAILED at matrix", m, i, j);
+						ok = false;
+					}
+				}
+	}
+
+	// one nd_range per matrix
+	const std::size_t launches = std::min<std::size_t>(batch, 1024);
+	report(samples::bench::run(opts, "gemm-per-matrix-" + shape, "fc32", launches,
+		3.0*launches*entries*sizeof(utx::fc32), 2.0*dim*entries*launches,
+		[&]
+		{
+			std::vector<sycl::event> events;
+			for (std::size_t m=0; m<launches; m++)
+				events.push_back(samples::gemm(queue, a.get()+m*entries, b.get()+m*entries, c.get()+m*entries, dim, dim, dim));
+			return events;
+		}
+	));
+	return ok;
+}
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	bool ok = run_batched<4>(queue, pool, opts, report);
+	ok = run_batched<8>(queue, pool, opts, report) && ok;
+	return ok ? 0 : 1;
+}
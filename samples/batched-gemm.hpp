@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::batched_gemm: C[b] = A[b] x B[b] for a batch of small square matrices
+// (4 x 4, 8 x 8) on usm memory, in one launch.
+//
+// Every work-item owns whole matrices: it keeps B in registers and computes C one row
+// at a time from one row of A. Element e = i*dim + j of matrix b is stored at
+//
+//	contiguous     ptr[b*stride + e]     (stride defaults to dim*dim, matrix after matrix)
+//	interleaved    ptr[e*stride + b]     (stride defaults to batch, entry e of every matrix together)
+//
+// The interleaved layout makes neighbouring work-items read neighbouring addresses, the
+// contiguous layout is what a plain array of matrices looks like.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace samples
+{
+
+struct batch_layout
+{
+	enum kind_type
+	{
+		contiguous,
+		interleaved,
+	};
+
+	kind_type kind = contiguous;
+	std::size_t stride = 0; // 0: dense
+
+	// Elements an array of batch matrices of dim x dim takes in this layout.
+	std::size_t extent(std::size_t dim, std::size_t batch) const
+	{
+		const std::size_t s = resolved(dim, batch);
+		return kind == contiguous ? (batch ? (batch-1)*s + dim*dim : 0) : (dim*dim-1)*s + batch;
+	}
+
+	std::size_t resolved(std::size_t dim, std::size_t batch) const
+	{
+		if (stride)
+			return stride;
+		return kind == contiguous ? dim*dim : batch;
+	}
+};
+
+template <typename raw_type, std::size_t dim>
+class batched_gemm_kernel
+{
+private:
+	const raw_type * a;
+	const raw_type * b;
+	raw_type * c;
+	std::size_t matrix_stride; // between matrices
+	std::size_t entry_stride; // between entries of one matrix
+public:
+	batched_gemm_kernel(const raw_type * a, const raw_type * b, raw_type * c, std::size_t matrix_stride, std::size_t entry_stride):
+		a{a},
+		b{b},
+		c{c},
+		matrix_stride{matrix_stride},
+		entry_stride{entry_stride}
+	{
+	}
+	void operator()(sycl::id<1> id) const
+	{
+		const std::size_t base = id[0]*matrix_stride;
+		raw_type mb[dim][dim];
+		for (std::size_t p=0; p<dim; p++)
+			for (std::size_t j=0; j<dim; j++)
+				mb[p][j] = b[base + (p*dim+j)*entry_stride];
+		for (std::size_t i=0; i<dim; i++)
+		{
+			raw_type row[dim];
+			for (std::size_t p=0; p<dim; p++)
+				row[p] = a[base + (i*dim+p)*entry_stride];
+			for (std::size_t j=0; j<dim; j++)
+			{
+				raw_type sum = 0;
+				for (std::size_t p=0; p<dim; p++)
+					sum += row[p]*mb[p][j];
+				c[base + (i*dim+j)*entry_stride] = sum;
+			}
+		}
+	}
+};
+
+// C[b] = A[b] x B[b] for b in [0, batch); a, b and c share one layout.
+template <std::size_t dim, typename data_type>
+sycl::event batched_gemm(
+	sycl::queue & queue,
+	const data_type * a, const data_type * b, data_type * c,
+	std::size_t batch,
+	batch_layout layout = {},
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	static_assert(dim >= 1 && dim <= 8, "samples::batched_gemm: matrices are kept in registers, dim <= 8");
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t stride = layout.resolved(dim, batch);
+	const std::size_t matrix_stride = layout.kind == batch_layout::contiguous ? stride : 1;
+	const std::size_t entry_stride = layout.kind == batch_layout::contiguous ? 1 : stride;
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for(
+				sycl::range<1>{batch},
+				batched_gemm_kernel<raw_type, dim>{raw_pointer(a), raw_pointer(b), raw_pointer(c), matrix_stride, entry_stride}
+			);
+		}
+	);
+}
+
+} // namespace samples
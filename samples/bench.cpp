@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Benchmark of the sample kernels on a profiling queue (see bench.hpp).
+//
+//	bench --size=16777216 --gemm-size=1024 --warmup=2 --repeat=10 --format=csv
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include <utxcpp/algorithm.hpp>
+#include <experimental/simd>
+#include "bench.hpp"
+#include "gemm.hpp"
+
+namespace stdx = std::experimental;
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+
+	const std::size_t size = opts.size;
+
+	// vector-add
+	{
+		std::vector<utx::ic32> add1(size), add2(size);
+		utx::iota(add1, 1);
+		utx::iota(add2, 37);
+		sycl::buffer<utx::ic32, 1> buff1{add1}, buff2{add2}, buff3{sycl::range<1>{size}};
+		report(samples::bench::run(opts, "vector-add", "ic32", size, 3.0*size*sizeof(utx::ic32), size,
+			[&]
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto acc1 = buff1.get_access<sycl::access_mode::read>(handler);
+						auto acc2 = buff2.get_access<sycl::access_mode::read>(handler);
+						auto acc3 = buff3.get_access<sycl::access_mode::write>(handler);
+						handler.parallel_for<class bench_vector_add>(
+							sycl::range<1>{size},
+							[=] (sycl::id<1> id)
+							{
+								acc3[id] = acc1[id] + acc2[id];
+							}
+						);
+					}
+				);
+			}
+		));
+	}
+
+	// sqrt, sin and cbrt on fc32, from an input that stays the same for every run
+	{
+		std::vector<utx::fc32> vector(size);
+		utx::iota(vector, 1.0f);
+		sycl::buffer<utx::fc32, 1> buff{vector};
+		sycl::buffer<utx::fc32, 1> result{sycl::range<1>{size}};
+		const double bytes = 2.0*size*sizeof(utx::fc32);
+
+		report(samples::bench::run(opts, "sqrt", "fc32", size, bytes, size,
+			[&]
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto in = buff.get_access<sycl::access_mode::read>(handler);
+						auto out = result.get_access<sycl::access_mode::write>(handler);
+						handler.parallel_for<class bench_sqrt>(
+							sycl::range<1>{size},
+							[=] (sycl::id<1> id)
+							{
+								out[id] = utx::sqrt(in[id]);
+							}
+						);
+					}
+				);
+			}
+		));
+
+		report(samples::bench::run(opts, "sin", "fc32", size, bytes, size,
+			[&]
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto in = buff.get_access<sycl::access_mode::read>(handler);
+						auto out = result.get_access<sycl::access_mode::write>(handler);
+						handler.parallel_for<class bench_sin>(
+							sycl::range<1>{size},
+							[=] (sycl::id<1> id)
+							{
+								out[id] = utx::sin(in[id]);
+							}
+						);
+					}
+				);
+			}
+		));
+
+		report(samples::bench::run(opts, "cbrt", "fc32", size, bytes, size,
+			[&]
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto in = buff.get_access<sycl::access_mode::read>(handler);
+						auto out = result.get_access<sycl::access_mode::write>(handler);
+						handler.parallel_for<class bench_cbrt>(
+							sycl::range<1>{size},
+							[=] (sycl::id<1> id)
+							{
+								out[id] = utx::cbrt(in[id]);
+							}
+						);
+					}
+				);
+			}
+		));
+	}
+
+	// std-simd squaring: one native_simd<u32> per item
+	{
+		using position_simd = stdx::native_simd<utx::u32>;
+		constexpr std::size_t width = position_simd::size();
+		const std::size_t count = samples::round_up(size, width);
+		std::vector<utx::u32> map(count);
+		utx::iota(map, 1u);
+		sycl::buffer<utx::u32, 1> buff{map};
+
+		report(samples::bench::run(opts, "std-simd", "u32", count, 2.0*count*sizeof(utx::u32), count,
+			[&]
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto acc = buff.get_access<sycl::access_mode::read_write>(handler);
+						handler.parallel_for<class bench_std_simd>(
+							sycl::range<1>{count/width},
+							[=] (sycl::id<1> id)
+							{
+								utx::u32 * pos = &acc[id[0]*width];
+								position_simd simd;
+								simd.copy_from(pos, stdx::element_aligned);
+								simd *= simd;
+								simd.copy_to(pos, stdx::element_aligned);
+							}
+						);
+					}
+				);
+			}
+		));
+	}
+
+	// matrix-mul
+	{
+		const std::size_t side = opts.gemm_size;
+		std::vector<utx::fc32> mat1(side*side), mat2(side*side);
+		utx::iota(mat1, 0.0f);
+		utx::iota(mat2, 0.0f);
+		sycl::buffer<utx::fc32, 2> buff1{mat1.data(), sycl::range<2>{side, side}};
+		sycl::buffer<utx::fc32, 2> buff2{mat2.data(), sycl::range<2>{side, side}};
+		sycl::buffer<utx::fc32, 2> buff3{sycl::range<2>{side, side}};
+
+		report(samples::bench::run(opts, "matrix-mul", "fc32", side,
+			3.0*side*side*sizeof(utx::fc32), 2.0*side*side*side,
+			[&]
+			{
+				return samples::gemm(queue, buff1, buff2, buff3);
+			}
+		));
+	}
+}
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::bench: timing through sycl event profiling.
+//
+//	A benchmark is a callable that submits one run and returns its sycl::event,
+//	or a std::vector<sycl::event> for a pipeline of several kernels.
+//	samples::bench::run calls it warmup times, then repeat times, and reads the
+//	event profiling info of every timed run:
+//		kernel time  = command_end - command_start (summed over a pipeline)
+//		latency      = command_end - command_submit (first submit to last end)
+//	samples::bench::run_host times a host callable with std::chrono instead, so host
+//	baselines (std::reduce, std::sort, ...) land in the same report.
+//	Results are printed as csv (default) or json lines, one line per benchmark.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "common.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace samples::bench
+{
+
+struct options
+{
+	std::size_t warmup = 2;
+	std::size_t repeat = 10;
+	std::size_t size = std::size_t{1} << 24; // elements of elementwise kernels
+	std::size_t gemm_size = 1024; // side of square matrix products
+	bool json = false;
+};
+
+// --warmup=N --repeat=N --size=N --gemm-size=N --format=csv|json
+inline options parse_options(int argc, char * argv[])
+{
+	options opts;
+	for (int i=1; i<argc; i++)
+	{
+		std::string_view arg{argv[i]};
+		auto value = [&arg] (std::string_view key, std::size_t & out)
+		{
+			if (! arg.starts_with(key))
+				return false;
+			out = std::strtoull(arg.data()+key.size(), nullptr, 10);
+			return true;
+		};
+		if (value("--warmup=", opts.warmup) || value("--repeat=", opts.repeat) ||
+			value("--size=", opts.size) || value("--gemm-size=", opts.gemm_size))
+			continue;
+		if (arg == "--format=json")
+			opts.json = true;
+		else if (arg == "--format=csv")
+			opts.json = false;
+		else
+			utx::printe("unknown option:", arg);
+	}
+	opts.repeat = std::max<std::size_t>(opts.repeat, 1);
+	return opts;
+}
+
+// Profiling queue on the gpu, or on the cpu when there is no gpu.
+inline sycl::queue make_queue()
+{
+	const sycl::property_list props{sycl::property::queue::enable_profiling{}};
+	try
+	{
+		return sycl::queue{sycl::gpu_selector_v, props};
+	}
+	catch (const sycl::exception &)
+	{
+		return sycl::queue{sycl::cpu_selector_v, props};
+	}
+}
+
+struct result
+{
+	std::string name;
+	std::string type;
+	std::size_t size = 0;
+	double kernel_ms = 0; // median
+	double kernel_min_ms = 0;
+	double latency_ms = 0; // median
+	double bytes = 0; // global memory traffic of one run
+	double flops = 0; // arithmetic operations of one run
+
+	double gbps() const
+	{
+		return kernel_ms > 0 ? bytes/kernel_ms*1e-6 : 0;
+	}
+	double gflops() const
+	{
+		return kernel_ms > 0 ? flops/kernel_ms*1e-6 : 0;
+	}
+	// size per second: elements, matrices, ... whatever size counts
+	double items_per_s() const
+	{
+		return kernel_ms > 0 ? size/kernel_ms*1e3 : 0;
+	}
+};
+
+inline double median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	const std::size_t half = values.size()/2;
+	return values.size()%2 ? values[half] : (values[half-1]+values[half])/2;
+}
+
+// Profiling timestamps of a finished event, in milliseconds.
+inline double kernel_ms(const sycl::event & event)
+{
+	const auto start = event.get_profiling_info<sycl::info::event_profiling::command_start>();
+	const auto end = event.get_profiling_info<sycl::info::event_profiling::command_end>();
+	return (end-start)*1e-6;
+}
+
+inline double latency_ms(const sycl::event & event)
+{
+	const auto submit = event.get_profiling_info<sycl::info::event_profiling::command_submit>();
+	const auto end = event.get_profiling_info<sycl::info::event_profiling::command_end>();
+	return (end-submit)*1e-6;
+}
+
+inline double kernel_ms(const std::vector<sycl::event> & events)
+{
+	double ms = 0;
+	for (const auto & event: events)
+		ms += kernel_ms(event);
+	return ms;
+}
+
+inline double latency_ms(const std::vector<sycl::event> & events)
+{
+	const auto submit = events.front().get_profiling_info<sycl::info::event_profiling::command_submit>();
+	const auto end = events.back().get_profiling_info<sycl::info::event_profiling::command_end>();
+	return (end-submit)*1e-6;
+}
+
+inline void wait(sycl::event & event)
+{
+	event.wait();
+}
+
+inline void wait(std::vector<sycl::event> & events)
+{
+	sycl::event::wait(events);
+}
+
+template <typename submit_type>
+result run(
+	const options & opts,
+	std::string name, std::string type, std::size_t size,
+	double bytes, double flops,
+	submit_type && submit
+)
+{
+	for (std::size_t i=0; i<opts.warmup; i++)
+	{
+		auto events = submit();
+		wait(events);
+	}
+
+	std::vector<double> kernel(opts.repeat), latency(opts.repeat);
+	for (std::size_t i=0; i<opts.repeat; i++)
+	{
+		auto events = submit();
+		wait(events);
+		kernel[i] = kernel_ms(events);
+		latency[i] = latency_ms(events);
+	}
+
+	result res;
+	res.name = std::move(name);
+	res.type = std::move(type);
+	res.size = size;
+	res.kernel_ms = median(kernel);
+	res.kernel_min_ms = *std::min_element(kernel.begin(), kernel.end());
+	res.latency_ms = median(latency);
+	res.bytes = bytes;
+	res.flops = flops;
+	return res;
+}
+
+template <typename call_type>
+result run_host(
+	const options & opts,
+	std::string name, std::string type, std::size_t size,
+	double bytes, double flops,
+	call_type && call
+)
+{
+	for (std::size_t i=0; i<opts.warmup; i++)
+		call();
+
+	std::vector<double> host(opts.repeat);
+	for (std::size_t i=0; i<opts.repeat; i++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		call();
+		host[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+	}
+
+	result res;
+	res.name = std::move(name);
+	res.type = std::move(type);
+	res.size = size;
+	res.kernel_ms = median(host);
+	res.kernel_min_ms = *std::min_element(host.begin(), host.end());
+	res.latency_ms = res.kernel_ms;
+	res.bytes = bytes;
+	res.flops = flops;
+	return res;
+}
+
+class reporter
+{
+private:
+	options opts;
+	std::string device;
+	bool header = false;
+public:
+	reporter(const options & opts, const sycl::queue & queue):
+		opts{opts},
+		device{queue.get_device().get_info<sycl::info::device::name>()}
+	{
+	}
+	void operator()(const result & res)
+	{
+		if (opts.json)
+		{
+			std::cout
+				<< "{\"name\":\"" << json_escape(res.name) << "\",\"type\":\"" << json_escape(res.type)
+				<< "\",\"size\":" << res.size
+				<< ",\"device\":\"" << json_escape(device) << '"'
+				<< ",\"warmup\":" << opts.warmup << ",\"repeat\":" << opts.repeat
+				<< ",\"kernel_ms\":" << res.kernel_ms << ",\"kernel_min_ms\":" << res.kernel_min_ms
+				<< ",\"latency_ms\":" << res.latency_ms
+				<< ",\"gbps\":" << res.gbps() << ",\"gflops\":" << res.gflops()
+				<< ",\"items_per_s\":" << res.items_per_s() << "}\n";
+			return;
+		}
+		if (! header)
+		{
+			std::cout << "name,type,size,device,warmup,repeat,kernel_ms,kernel_min_ms,latency_ms,gbps,gflops,items_per_s\n";
+			header = true;
+		}
+		std::cout
+			<< res.name << ',' << res.type << ',' << res.size << ",\"" << device << "\","
+			<< opts.warmup << ',' << opts.repeat << ','
+			<< res.kernel_ms << ',' << res.kernel_min_ms << ',' << res.latency_ms << ','
+			<< res.gbps() << ',' << res.gflops() << ',' << res.items_per_s() << '\n';
+	}
+};
+
+} // namespace samples::bench
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Small helpers shared by the sample headers.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace samples
+{
+
+inline std::size_t round_up(std::size_t value, std::size_t multiple)
+{
+	return (value+multiple-1)/multiple*multiple;
+}
+
+// Value type under a utx class type (utx::fc32 -> float), or the type itself.
+template <typename data_type>
+struct raw_value
+{
+	using type = data_type;
+};
+
+template <typename data_type>
+	requires std::is_class_v<data_type>
+struct raw_value<data_type>
+{
+	using type = std::remove_cvref_t<decltype(std::declval<const data_type &>()())>;
+};
+
+template <typename data_type>
+using raw_value_t = typename raw_value<data_type>::type;
+
+// x() for utx class types, x itself for fundamental types
+template <typename data_type>
+raw_value_t<data_type> to_raw(const data_type & x)
+{
+	if constexpr (std::is_class_v<data_type>)
+		return x();
+	else
+		return x;
+}
+
+template <typename data_type>
+const raw_value_t<data_type> * raw_pointer(const data_type * ptr)
+{
+	static_assert(sizeof(raw_value_t<data_type>) == sizeof(data_type));
+	return std::bit_cast<const raw_value_t<data_type> *>(ptr);
+}
+
+template <typename data_type>
+raw_value_t<data_type> * raw_pointer(data_type * ptr)
+{
+	static_assert(sizeof(raw_value_t<data_type>) == sizeof(data_type));
+	return std::bit_cast<raw_value_t<data_type> *>(ptr);
+}
+
+template <int dims>
+sycl::range<dims> to_range(const std::array<std::size_t, dims> & values)
+{
+	if constexpr (dims == 1)
+		return sycl::range<1>{values[0]};
+	else if constexpr (dims == 2)
+		return sycl::range<2>{values[0], values[1]};
+	else
+		return sycl::range<3>{values[0], values[1], values[2]};
+}
+
+// text as the contents of a json string: quotes, backslashes and control characters escaped
+inline std::string json_escape(std::string_view text)
+{
+	std::string out;
+	out.reserve(text.size());
+	for (const char c: text)
+	{
+		switch (c)
+		{
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+			{
+				char code[8];
+				std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+				out += code;
+			}
+			else
+				out += c;
+		}
+	}
+	return out;
+}
+
+} // namespace samples
@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::fusion: elementwise expression templates.
+//
+//	auto x = fusion::arg(px), y = fusion::arg(py), z = fusion::arg(pz);
+//	fusion::assign(queue, out, fusion::sqrt(fusion::sin(x)) * y + z, size);
+//
+// The expression is a tree of small device-copyable functors; assign() runs it
+// in one kernel (fusion::kernel_class, a functor kernel in the style of
+// utx_cbrt_kernel_class), so every element is read and written once instead of
+// once per operation.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/math.hpp>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace samples::fusion
+{
+
+struct expression_tag
+{
+};
+
+template <typename type>
+constexpr bool is_expression_v = std::is_base_of_v<expression_tag, std::remove_cvref_t<type>>;
+
+// leaf: element i of a usm pointer or of a 1d accessor
+template <typename source_type>
+struct terminal: expression_tag
+{
+	source_type source;
+
+	auto operator()(std::size_t i) const
+	{
+		return source[i];
+	}
+};
+
+// leaf: the same value for every element
+template <typename value_type>
+struct scalar: expression_tag
+{
+	value_type value;
+
+	value_type operator()(std::size_t) const
+	{
+		return value;
+	}
+};
+
+template <typename op_type, typename arg_type>
+struct unary: expression_tag
+{
+	arg_type arg;
+
+	auto operator()(std::size_t i) const
+	{
+		return op_type{}(arg(i));
+	}
+};
+
+template <typename op_type, typename lhs_type, typename rhs_type>
+struct binary: expression_tag
+{
+	lhs_type lhs;
+	rhs_type rhs;
+
+	auto operator()(std::size_t i) const
+	{
+		return op_type{}(lhs(i), rhs(i));
+	}
+};
+
+template <typename source_type>
+terminal<source_type> arg(source_type source)
+{
+	return {{}, source};
+}
+
+template <typename type>
+auto as_expression(const type & value)
+{
+	if constexpr (is_expression_v<type>)
+		return value;
+	else
+		return scalar<type>{{}, value};
+}
+
+#define SAMPLES_FUSION_UNARY(name, call) \
+	struct name##_op \
+	{ \
+		template <typename type> \
+		auto operator()(const type & x) const \
+		{ \
+			return call(x); \
+		} \
+	}; \
+	template <typename arg_type> \
+		requires is_expression_v<arg_type> \
+	unary<name##_op, arg_type> name(const arg_type & x) \
+	{ \
+		return {{}, x}; \
+	}
+
+SAMPLES_FUSION_UNARY(sqrt, utx::sqrt)
+SAMPLES_FUSION_UNARY(cbrt, utx::cbrt)
+SAMPLES_FUSION_UNARY(sin, utx::sin)
+SAMPLES_FUSION_UNARY(cos, utx::cos)
+
+#undef SAMPLES_FUSION_UNARY
+
+#define SAMPLES_FUSION_BINARY(name, op) \
+	struct name##_op \
+	{ \
+		template <typename lhs_type, typename rhs_type> \
+		auto operator()(const lhs_type & x, const rhs_type & y) const \
+		{ \
+			return x op y; \
+		} \
+	}; \
+	template <typename lhs_type, typename rhs_type> \
+		requires (is_expression_v<lhs_type> || is_expression_v<rhs_type>) \
+	auto operator op(const lhs_type & x, const rhs_type & y) \
+	{ \
+		using l_type = decltype(as_expression(x)); \
+		using r_type = decltype(as_expression(y)); \
+		return binary<name##_op, l_type, r_type>{{}, as_expression(x), as_expression(y)}; \
+	}
+
+SAMPLES_FUSION_BINARY(plus, +)
+SAMPLES_FUSION_BINARY(minus, -)
+SAMPLES_FUSION_BINARY(multiplies, *)
+SAMPLES_FUSION_BINARY(divides, /)
+
+#undef SAMPLES_FUSION_BINARY
+
+template <typename data_type, typename expression_type>
+class kernel_class
+{
+private:
+	data_type * out;
+	expression_type expression;
+public:
+	kernel_class(data_type * out, expression_type expression):
+		out{out},
+		expression{expression}
+	{
+	}
+	void operator()(sycl::id<1> id) const
+	{
+		out[id[0]] = data_type(expression(id[0]));
+	}
+};
+
+// out[i] = expression(i) for i in [0, size), as one kernel.
+template <typename data_type, typename expression_type>
+sycl::event assign(
+	sycl::queue & queue,
+	data_type * out,
+	const expression_type & expression,
+	std::size_t size,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for(
+				sycl::range<1>{size},
+				kernel_class<data_type, std::remove_cvref_t<decltype(as_expression(expression))>>{
+					out, as_expression(expression)
+				}
+			);
+		}
+	);
+}
+
+} // namespace samples::fusion
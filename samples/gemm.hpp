@@ -0,0 +1,244 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::gemm: C = A x B for any M x K by K x N row-major matrices.
+//
+//	Every work-group computes one tile x tile block of C. Per step of K it stages
+//	a tile x k_tile slice of A and a k_tile x tile slice of B in local memory,
+//	then every item accumulates its own register_block x register_block
+//	sub-block of C in private memory. Out-of-range elements are loaded as 0 and
+//	never stored, so M, N and K do not have to be multiples of the tile.
+//	Tiles that exceed the device work-group or local memory limits throw
+//	std::invalid_argument (check_gemm_tile) before anything is enqueued.
+//	Both sycl::buffer and usm pointers are accepted. gemm_tiled_core leaves the
+//	element types and accesses open for the mixed precision kernels (quantized-gemm.hpp).
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "tuner.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace samples
+{
+
+template <std::size_t wg=16, std::size_t rb=4, std::size_t tk=16>
+struct gemm_tile
+{
+	static constexpr std::size_t work_group = wg; // local range is wg x wg
+	static constexpr std::size_t register_block = rb; // every item owns rb x rb elements of C
+	static constexpr std::size_t tile = wg*rb; // every group owns tile x tile elements of C
+	static constexpr std::size_t k_tile = tk;
+};
+
+template <typename data_type, typename tile_type, bool usm>
+class gemm_tiled_kernel;
+
+// Throws std::invalid_argument when the wg x wg local range or the local memory of
+// tile_type do not fit the device; pick a smaller gemm_tile there.
+template <typename tile_type, typename local_type>
+void check_gemm_tile(const sycl::device & device)
+{
+	const device_caps & caps = capabilities(device);
+	constexpr std::size_t wg = tile_type::work_group;
+	const std::string name = "samples::gemm: tile " + std::to_string(tile_type::tile) +
+		" (work group " + std::to_string(wg) + " x " + std::to_string(wg) + ")";
+	if (wg*wg > caps.max_work_group_size || wg > caps.max_work_item_size)
+		throw std::invalid_argument{name + " exceeds the work-group limit of " + caps.name};
+	if (2*tile_type::tile*tile_type::k_tile*sizeof(local_type) > caps.local_mem_size)
+		throw std::invalid_argument{name + " exceeds the local memory of " + caps.name};
+}
+
+// Row-major matrix on a usm pointer, indexed like a 2d accessor: mat[row][col].
+template <typename data_type>
+struct row_major
+{
+	data_type * ptr;
+	std::size_t ld;
+
+	data_type * operator[](std::size_t row) const
+	{
+		return ptr + row*ld;
+	}
+};
+
+// Enqueues the tiled kernel with the element access left to the caller:
+//	load_a(row, q) and load_b(q, col) return the in-range elements of A and B as local_type,
+//	store(row, col, sum) writes an in-range element of C from its accumulator.
+// Local memory holds local_type, the registers accumulate in accumulator_type, so narrow
+// inputs (sycl::half, int8) keep their smaller footprint up to the multiply.
+// Nothing is checked here: callers run check_gemm_tile on the queue's device first.
+template <typename kernel_name, typename local_type, typename accumulator_type, typename tile_type,
+	typename load_a_type, typename load_b_type, typename store_type>
+void gemm_tiled_core(
+	sycl::handler & handler,
+	load_a_type load_a, load_b_type load_b, store_type store,
+	std::size_t m, std::size_t n, std::size_t k
+)
+{
+	constexpr std::size_t wg = tile_type::work_group;
+	constexpr std::size_t rb = tile_type::register_block;
+	constexpr std::size_t tm = tile_type::tile;
+	constexpr std::size_t tk = tile_type::k_tile;
+
+	auto lm_a = sycl::local_accessor<local_type, 2>{sycl::range<2>{tm, tk}, handler};
+	auto lm_b = sycl::local_accessor<local_type, 2>{sycl::range<2>{tk, tm}, handler};
+
+	handler.parallel_for<kernel_name>(
+		sycl::nd_range<2>{
+			sycl::range<2>{round_up(m, tm)/rb, round_up(n, tm)/rb},
+			sycl::range<2>{wg, wg}
+		},
+		[=] (sycl::nd_item<2> item)
+		{
+			const std::size_t lid0 = item.get_local_id(0);
+			const std::size_t lid1 = item.get_local_id(1);
+			const std::size_t lin = lid0*wg + lid1;
+			const std::size_t row0 = item.get_group(0)*tm;
+			const std::size_t col0 = item.get_group(1)*tm;
+
+			// Rows and columns of an item are strided by wg, so neighbouring items
+			// read neighbouring local memory in the inner loop.
+			accumulator_type sum[rb][rb];
+			for (std::size_t i=0; i<rb; i++)
+				for (std::size_t j=0; j<rb; j++)
+					sum[i][j] = accumulator_type(0);
+
+			for (std::size_t k0=0; k0<k; k0+=tk)
+			{
+				// cooperative load of the A and B slices, zero padded at the edges
+				for (std::size_t e=lin; e<tm*tk; e+=wg*wg)
+				{
+					const std::size_t r = e/tk, q = e%tk;
+					const std::size_t gr = row0+r, gq = k0+q;
+					lm_a[r][q] = gr<m && gq<k ? load_a(gr, gq) : local_type(0);
+				}
+				for (std::size_t e=lin; e<tk*tm; e+=wg*wg)
+				{
+					const std::size_t q = e/tm, r = e%tm;
+					const std::size_t gq = k0+q, gc = col0+r;
+					lm_b[q][r] = gq<k && gc<n ? load_b(gq, gc) : local_type(0);
+				}
+				sycl::group_barrier(item.get_group());
+
+				for (std::size_t q=0; q<tk; q++)
+				{
+					accumulator_type reg_a[rb], reg_b[rb];
+					for (std::size_t i=0; i<rb; i++)
+						reg_a[i] = accumulator_type(lm_a[lid0+i*wg][q]);
+					for (std::size_t j=0; j<rb; j++)
+						reg_b[j] = accumulator_type(lm_b[q][lid1+j*wg]);
+					for (std::size_t i=0; i<rb; i++)
+						for (std::size_t j=0; j<rb; j++)
+							sum[i][j] += reg_a[i] * reg_b[j];
+				}
+				sycl::group_barrier(item.get_group());
+			}
+
+			for (std::size_t i=0; i<rb; i++)
+			{
+				const std::size_t gr = row0+lid0+i*wg;
+				if (gr >= m)
+					break;
+				for (std::size_t j=0; j<rb; j++)
+				{
+					const std::size_t gc = col0+lid1+j*wg;
+					if (gc < n)
+						store(gr, gc, sum[i][j]);
+				}
+			}
+		}
+	);
+}
+
+// Enqueues the tiled kernel; a, b and c are 2d accessors or samples::row_major.
+// See check_gemm_tile for the device limits.
+template <typename data_type, typename tile_type, bool usm, typename a_type, typename b_type, typename c_type>
+void gemm_tiled(
+	sycl::handler & handler,
+	a_type acc_a, b_type acc_b, c_type acc_c,
+	std::size_t m, std::size_t n, std::size_t k
+)
+{
+	gemm_tiled_core<gemm_tiled_kernel<data_type, tile_type, usm>, data_type, data_type, tile_type>(
+		handler,
+		[=] (std::size_t row, std::size_t q)
+		{
+			return data_type(acc_a[row][q]);
+		},
+		[=] (std::size_t q, std::size_t col)
+		{
+			return data_type(acc_b[q][col]);
+		},
+		[=] (std::size_t row, std::size_t col, const data_type & sum)
+		{
+			acc_c[row][col] = sum;
+		},
+		m, n, k
+	);
+}
+
+template <typename data_type, typename tile_type=gemm_tile<>>
+sycl::event gemm(
+	sycl::queue & queue,
+	sycl::buffer<data_type, 2> & a,
+	sycl::buffer<data_type, 2> & b,
+	sycl::buffer<data_type, 2> & c,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	const std::size_t m = a.get_range()[0];
+	const std::size_t k = a.get_range()[1];
+	const std::size_t n = b.get_range()[1];
+	if (b.get_range()[0] != k || c.get_range()[0] != m || c.get_range()[1] != n)
+		throw std::invalid_argument{"samples::gemm: matrix extents do not match"};
+	check_gemm_tile<tile_type, data_type>(queue.get_device());
+
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			auto acc_a = sycl::accessor{a, handler, sycl::read_only};
+			auto acc_b = sycl::accessor{b, handler, sycl::read_only};
+			auto acc_c = sycl::accessor{c, handler, sycl::write_only, sycl::no_init};
+			gemm_tiled<data_type, tile_type, false>(handler, acc_a, acc_b, acc_c, m, n, k);
+		}
+	);
+}
+
+// usm version: a is m x k, b is k x n, c is m x n, all row-major and dense.
+template <typename data_type, typename tile_type=gemm_tile<>>
+sycl::event gemm(
+	sycl::queue & queue,
+	const data_type * a,
+	const data_type * b,
+	data_type * c,
+	std::size_t m, std::size_t n, std::size_t k,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	check_gemm_tile<tile_type, data_type>(queue.get_device());
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			gemm_tiled<data_type, tile_type, true>(
+				handler,
+				row_major<const data_type>{a, k},
+				row_major<const data_type>{b, n},
+				row_major<data_type>{c, n},
+				m, n, k
+			);
+		}
+	);
+}
+
+} // namespace samples
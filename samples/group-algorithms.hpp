@@ -0,0 +1,332 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Device-wide reduce and scan on usm memory, built on the sycl 2020 group algorithms.
+//
+//	samples::reduce             two passes: every group reduces a grid-stride slice with
+//	                            reduce_over_group, one group joint_reduce's the partials.
+//	samples::inclusive_scan     three passes (reduce, scan, downsweep): block sums, a scan
+//	samples::exclusive_scan     of the block sums, every block scans its elements and adds
+//	                            its offset. The block sums are scanned by one group with
+//	                            joint_exclusive_scan when they fit in one block, and by
+//	                            the same three passes (recursively) when they do not.
+//	samples::segmented_*        one group per segment [offsets[s], offsets[s+1]) with the
+//	                            joint_ algorithms.
+//
+// utx class types (utx::ic32, utx::uc32, utx::fc32, ...) are processed as their raw
+// value type, the group algorithms only take fundamental types. Scratch memory comes
+// from a samples::usm_pool and goes back to it when the last kernel has finished.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "tuner.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace samples
+{
+
+inline std::size_t algorithm_work_group(const sycl::queue & queue)
+{
+	return std::min<std::size_t>(256, capabilities(queue.get_device()).max_work_group_size);
+}
+
+// Kernel names are keyed on the element type as it is passed in (utx::fc32 and float
+// name different kernels), and the scan of the block sums inside a scan is nested.
+template <typename data_type, typename op_type, int pass>
+class reduce_kernel;
+
+template <typename data_type, typename op_type, int pass, bool inclusive, bool nested>
+class scan_kernel;
+
+template <typename data_type, typename op_type, bool inclusive>
+class segmented_kernel;
+
+// *out = op-reduction of in[0, size)
+template <typename data_type, typename op_type=sycl::plus<>>
+sycl::event reduce(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const data_type * in, std::size_t size,
+	data_type * out,
+	op_type op = {},
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t wg = algorithm_work_group(queue);
+	const std::size_t groups = std::clamp<std::size_t>((size+wg-1)/wg, 1, wg*4);
+	raw_type * partial = pool.allocate<raw_type>(groups);
+	const raw_type * src = raw_pointer(in);
+	raw_type * dst = raw_pointer(out);
+
+	sycl::event first = queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<reduce_kernel<data_type, op_type, 0>>(
+				sycl::nd_range<1>{groups*wg, wg},
+				[=] (sycl::nd_item<1> item)
+				{
+					raw_type sum = sycl::known_identity_v<op_type, raw_type>;
+					for (std::size_t i=item.get_global_id(0); i<size; i+=item.get_global_range(0))
+						sum = op(sum, src[i]);
+					sum = sycl::reduce_over_group(item.get_group(), sum, op);
+					if (item.get_local_id(0) == 0)
+						partial[item.get_group(0)] = sum;
+				}
+			);
+		}
+	);
+	sycl::event second = queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(first);
+			handler.parallel_for<reduce_kernel<data_type, op_type, 1>>(
+				sycl::nd_range<1>{wg, wg},
+				[=] (sycl::nd_item<1> item)
+				{
+					const raw_type sum = sycl::joint_reduce(item.get_group(), partial, partial+groups, op);
+					if (item.get_local_id(0) == 0)
+						*dst = sum;
+				}
+			);
+		}
+	);
+	release_after(queue, pool, partial, second);
+	return second;
+}
+
+// nested: the scan of the block sums of an outer scan
+template <bool inclusive, bool nested = false, typename data_type, typename op_type>
+sycl::event scan(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const data_type * in, std::size_t size,
+	data_type * out,
+	op_type op,
+	const std::vector<sycl::event> & deps
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	constexpr std::size_t per_item = 8;
+	const std::size_t wg = algorithm_work_group(queue);
+	const std::size_t block = wg*per_item;
+	const std::size_t blocks = std::max<std::size_t>((size+block-1)/block, 1);
+	raw_type * sums = pool.allocate<raw_type>(blocks);
+	raw_type * offsets = pool.allocate<raw_type>(blocks);
+	const raw_type * src = raw_pointer(in);
+	raw_type * dst = raw_pointer(out);
+
+	// 1. sum of every block
+	sycl::event reduced = queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<scan_kernel<data_type, op_type, 0, inclusive, nested>>(
+				sycl::nd_range<1>{blocks*wg, wg},
+				[=] (sycl::nd_item<1> item)
+				{
+					const std::size_t base = item.get_group(0)*block + item.get_local_id(0)*per_item;
+					raw_type sum = sycl::known_identity_v<op_type, raw_type>;
+					for (std::size_t j=0; j<per_item; j++)
+						if (base+j < size)
+							sum = op(sum, src[base+j]);
+					sum = sycl::reduce_over_group(item.get_group(), sum, op);
+					if (item.get_local_id(0) == 0)
+						sums[item.get_group(0)] = sum;
+				}
+			);
+		}
+	);
+
+	// 2. offset of every block: one group, or a scan of the block sums when there are more than a block
+	sycl::event scanned;
+	if (blocks > block)
+		scanned = scan<false, true>(queue, pool, sums, blocks, offsets, op, {reduced});
+	else
+		scanned = queue.submit(
+			[&] (sycl::handler & handler)
+			{
+				handler.depends_on(reduced);
+				handler.parallel_for<scan_kernel<data_type, op_type, 1, inclusive, nested>>(
+					sycl::nd_range<1>{wg, wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						sycl::joint_exclusive_scan(item.get_group(), sums, sums+blocks, offsets, op);
+					}
+				);
+			}
+		);
+
+	// 3. every item scans per_item consecutive elements, offset by the items and blocks before it
+	sycl::event downsweep = queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(scanned);
+			handler.parallel_for<scan_kernel<data_type, op_type, 2, inclusive, nested>>(
+				sycl::nd_range<1>{blocks*wg, wg},
+				[=] (sycl::nd_item<1> item)
+				{
+					constexpr raw_type identity = sycl::known_identity_v<op_type, raw_type>;
+					const std::size_t base = item.get_group(0)*block + item.get_local_id(0)*per_item;
+					raw_type values[per_item];
+					raw_type total = identity;
+					for (std::size_t j=0; j<per_item; j++)
+					{
+						values[j] = base+j < size ? src[base+j] : identity;
+						total = op(total, values[j]);
+					}
+					const raw_type before = sycl::exclusive_scan_over_group(item.get_group(), total, op);
+					raw_type running = op(offsets[item.get_group(0)], before);
+					for (std::size_t j=0; j<per_item && base+j<size; j++)
+					{
+						if constexpr (inclusive)
+						{
+							running = op(running, values[j]);
+							dst[base+j] = running;
+						}
+						else
+						{
+							dst[base+j] = running;
+							running = op(running, values[j]);
+						}
+					}
+				}
+			);
+		}
+	);
+	release_after(queue, pool, sums, downsweep);
+	release_after(queue, pool, offsets, downsweep);
+	return downsweep;
+}
+
+template <typename data_type, typename op_type=sycl::plus<>>
+sycl::event inclusive_scan(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const data_type * in, std::size_t size,
+	data_type * out,
+	op_type op = {},
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return scan<true>(queue, pool, in, size, out, op, deps);
+}
+
+template <typename data_type, typename op_type=sycl::plus<>>
+sycl::event exclusive_scan(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const data_type * in, std::size_t size,
+	data_type * out,
+	op_type op = {},
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return scan<false>(queue, pool, in, size, out, op, deps);
+}
+
+// out[s] = op-reduction of in[offsets[s], offsets[s+1]) for s in [0, segments)
+template <typename data_type, typename op_type=sycl::plus<>>
+sycl::event segmented_reduce(
+	sycl::queue & queue,
+	const data_type * in, const std::size_t * offsets, std::size_t segments,
+	data_type * out,
+	op_type op = {},
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t wg = algorithm_work_group(queue);
+	const raw_type * src = raw_pointer(in);
+	raw_type * dst = raw_pointer(out);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<reduce_kernel<data_type, op_type, 2>>(
+				sycl::nd_range<1>{segments*wg, wg},
+				[=] (sycl::nd_item<1> item)
+				{
+					const std::size_t s = item.get_group(0);
+					const raw_type sum = sycl::joint_reduce(item.get_group(), src+offsets[s], src+offsets[s+1],
+						sycl::known_identity_v<op_type, raw_type>, op);
+					if (item.get_local_id(0) == 0)
+						dst[s] = sum;
+				}
+			);
+		}
+	);
+}
+
+// scan of every segment [offsets[s], offsets[s+1]) on its own
+template <bool inclusive, typename data_type, typename op_type>
+sycl::event segmented_scan(
+	sycl::queue & queue,
+	const data_type * in, const std::size_t * offsets, std::size_t segments,
+	data_type * out,
+	op_type op,
+	const std::vector<sycl::event> & deps
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t wg = algorithm_work_group(queue);
+	const raw_type * src = raw_pointer(in);
+	raw_type * dst = raw_pointer(out);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<segmented_kernel<data_type, op_type, inclusive>>(
+				sycl::nd_range<1>{segments*wg, wg},
+				[=] (sycl::nd_item<1> item)
+				{
+					const std::size_t s = item.get_group(0);
+					const raw_type * first = src+offsets[s];
+					const raw_type * last = src+offsets[s+1];
+					if constexpr (inclusive)
+						sycl::joint_inclusive_scan(item.get_group(), first, last, dst+offsets[s], op);
+					else
+						sycl::joint_exclusive_scan(item.get_group(), first, last, dst+offsets[s],
+							sycl::known_identity_v<op_type, raw_type>, op);
+				}
+			);
+		}
+	);
+}
+
+template <typename data_type, typename op_type=sycl::plus<>>
+sycl::event segmented_inclusive_scan(
+	sycl::queue & queue,
+	const data_type * in, const std::size_t * offsets, std::size_t segments,
+	data_type * out,
+	op_type op = {},
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return segmented_scan<true>(queue, in, offsets, segments, out, op, deps);
+}
+
+template <typename data_type, typename op_type=sycl::plus<>>
+sycl::event segmented_exclusive_scan(
+	sycl::queue & queue,
+	const data_type * in, const std::size_t * offsets, std::size_t segments,
+	data_type * out,
+	op_type op = {},
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return segmented_scan<false>(queue, in, offsets, segments, out, op, deps);
+}
+
+} // namespace samples
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Local memory and global atomic histograms (see histogram.hpp) on uniform and skewed keys.
+//
+//	histogram --size=16777216 --warmup=2 --repeat=10 --format=csv
+//
+// fc32 keys in [0, 1) and uc32 keys in [0, 2^20), either uniform or skewed: u^8 for a
+// uniform u, which puts half of the keys into the lowest 1/256 of the range. The bin
+// counts go from 64 to 2^20 bins; the local path runs where the bins fit in local memory
+// and the global path always. Every histogram is checked on the host.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "histogram.hpp"
+#include "random.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+template <typename key_type>
+class runner
+{
+private:
+	sycl::queue & queue;
+	const samples::bench::options & opts;
+	samples::bench::reporter & report;
+	samples::usm_pool & pool;
+	std::string type;
+	typename samples::binning<key_type>::raw_type high;
+
+public:
+	runner(sycl::queue & queue, const samples::bench::options & opts, samples::bench::reporter & report,
+		samples::usm_pool & pool, std::string type, typename samples::binning<key_type>::raw_type high):
+		queue{queue},
+		opts{opts},
+		report{report},
+		pool{pool},
+		type{std::move(type)},
+		high{high}
+	{
+	}
+
+	bool operator()(const std::string & distribution, const std::vector<key_type> & host_keys)
+	{
+		using raw_type = typename samples::binning<key_type>::raw_type;
+		const std::size_t size = host_keys.size();
+		auto keys = samples::make_pooled<key_type>(pool, size);
+		queue.memcpy(keys.get(), host_keys.data(), size*sizeof(key_type)).wait();
+		bool ok = true;
+
+		for (std::size_t bins: {std::size_t{64}, std::size_t{256}, std::size_t{4096}, std::size_t{1} << 20})
+		{
+			const samples::binning<key_type> bin{raw_type(0), high, bins};
+			std::vector<std::uint32_t> want(bins, 0), got(bins);
+			for (const auto & key: host_keys)
+				if (const std::size_t b = bin(samples::to_raw(key)); b < bins)
+					want[b]++;
+			auto counts = samples::make_pooled<std::uint32_t>(pool, bins);
+
+			auto run = [&] (samples::histogram_path path, const std::string & label)
+			{
+				const std::string name = "histogram-" + label + "-" + distribution + "-" + std::to_string(bins);
+				report(samples::bench::run(opts, name, type, size, size*sizeof(key_type) + bins*sizeof(std::uint32_t), size,
+					[&] { return samples::histogram(queue, keys.get(), size, bin, counts.get(), path); }));
+				queue.memcpy(got.data(), counts.get(), bins*sizeof(std::uint32_t)).wait();
+				if (got != want)
+				{
+					utx::printe(name, "FAILED");
+					ok = false;
+				}
+			};
+			if (samples::histogram_fits_local(queue.get_device(), bins))
+				run(samples::histogram_path::local, "local");
+			else
+				utx::printe("histogram-local", bins, "bins do not fit in local memory");
+			run(samples::histogram_path::global, "global");
+		}
+		return ok;
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t size = opts.size;
+	std::vector<utx::fc32> uniform(size), skewed(size);
+	samples::random::generate(uniform.data(), size,
+		samples::random::uniform_generator<utx::fc32>{samples::random::make_key(2023), 0, 0.0f, 1.0f});
+	for (std::size_t i=0; i<size; i++)
+		skewed[i] = std::pow(uniform[i](), 8.0f);
+
+	constexpr std::uint32_t key_range = 1 << 20;
+	std::vector<utx::uc32> uniform_u(size), skewed_u(size);
+	for (std::size_t i=0; i<size; i++)
+	{
+		uniform_u[i] = static_cast<std::uint32_t>(uniform[i]()*key_range);
+		skewed_u[i] = static_cast<std::uint32_t>(skewed[i]()*key_range);
+	}
+
+	runner<utx::fc32> floats{queue, opts, report, pool, "fc32", 1.0f};
+	bool ok = floats("uniform", uniform);
+	ok = floats("skewed", skewed) && ok;
+	runner<utx::uc32> integers{queue, opts, report, pool, "uc32", key_range};
+	ok = integers("uniform", uniform_u) && ok;
+	ok = integers("skewed", skewed_u) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::histogram: counts of integer or floating point keys in equal-width bins.
+//
+//	samples::histogram(queue, keys, size, samples::binning<utx::fc32>{0.0f, 1.0f, 256}, counts);
+//
+// Bin b counts the keys in [low + b*w, low + (b+1)*w), w = (high-low)/bins; keys outside
+// [low, high) and NaNs are not counted. counts holds bins std::uint32_t and is cleared first.
+//	histogram_path::local     every work-group counts its grid-stride slice of the keys in
+//	                          its own local memory bins with work_group atomic_refs, then
+//	                          adds the non-zero bins to counts with device atomic_refs.
+//	histogram_path::global    every key is a device atomic_ref add on counts.
+//	histogram_path::automatic local when the bins fit in half of local_mem_size, global
+//	                          otherwise.
+// Private bins turn the atomics on a few hot bins of a skewed input into local memory
+// atomics, and the global traffic into one add per bin and work-group.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "tuner.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace samples
+{
+
+enum class histogram_path
+{
+	automatic,
+	local,
+	global,
+};
+
+template <typename key_type>
+struct binning
+{
+	using raw_type = raw_value_t<key_type>;
+	static_assert(std::is_floating_point_v<raw_type> || (std::is_integral_v<raw_type> && sizeof(raw_type) <= 4),
+		"samples::binning takes floating point and 8 to 32 bit integer keys");
+
+	raw_type low, high;
+	std::size_t bins;
+
+	// the bin of key, or bins when key is not counted
+	std::size_t operator()(raw_type key) const
+	{
+		if (! (key >= low && key < high))
+			return bins;
+		if constexpr (std::is_floating_point_v<raw_type>)
+			return std::min(static_cast<std::size_t>((key-low)/(high-low)*static_cast<raw_type>(bins)), bins-1);
+		else
+			return static_cast<std::size_t>(
+				static_cast<std::uint64_t>(std::int64_t{key} - std::int64_t{low})*bins /
+				static_cast<std::uint64_t>(std::int64_t{high} - std::int64_t{low}));
+	}
+};
+
+template <typename raw_type, bool local>
+class histogram_kernel;
+
+// local memory bins fit when they take at most half of it
+inline bool histogram_fits_local(const sycl::device & device, std::size_t bins)
+{
+	return bins*sizeof(std::uint32_t) <= capabilities(device).local_mem_size/2;
+}
+
+template <typename key_type>
+sycl::event histogram(
+	sycl::queue & queue,
+	const key_type * keys, std::size_t size,
+	binning<key_type> bin,
+	std::uint32_t * counts,
+	histogram_path path = histogram_path::automatic,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<key_type>;
+	const device_caps & caps = capabilities(queue.get_device());
+	const std::size_t wg = std::min<std::size_t>(256, caps.max_work_group_size);
+	const std::size_t groups = std::clamp<std::size_t>((size+wg-1)/wg, 1, caps.compute_units*4);
+	const std::size_t bins = bin.bins;
+	const bool local = path == histogram_path::local ||
+		(path == histogram_path::automatic && histogram_fits_local(queue.get_device(), bins));
+	const raw_type * src = raw_pointer(keys);
+	const binning<raw_type> raw_bin{bin.low, bin.high, bins};
+
+	sycl::event cleared = queue.memset(counts, 0, bins*sizeof(std::uint32_t), deps);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(cleared);
+			if (local)
+			{
+				auto lm = sycl::local_accessor<std::uint32_t, 1>{sycl::range<1>{bins}, handler};
+				handler.parallel_for<histogram_kernel<raw_type, true>>(
+					sycl::nd_range<1>{groups*wg, wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const std::size_t lid = item.get_local_id(0);
+						for (std::size_t b=lid; b<bins; b+=wg)
+							lm[b] = 0;
+						sycl::group_barrier(item.get_group());
+						for (std::size_t i=item.get_global_id(0); i<size; i+=item.get_global_range(0))
+						{
+							const std::size_t b = raw_bin(src[i]);
+							if (b < bins)
+								sycl::atomic_ref<std::uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::work_group,
+									sycl::access::address_space::local_space>{lm[b]}.fetch_add(1);
+						}
+						sycl::group_barrier(item.get_group());
+						for (std::size_t b=lid; b<bins; b+=wg)
+							if (lm[b])
+								sycl::atomic_ref<std::uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device,
+									sycl::access::address_space::global_space>{counts[b]}.fetch_add(lm[b]);
+					}
+				);
+			}
+			else
+			{
+				handler.parallel_for<histogram_kernel<raw_type, false>>(
+					sycl::nd_range<1>{groups*wg, wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						for (std::size_t i=item.get_global_id(0); i<size; i+=item.get_global_range(0))
+						{
+							const std::size_t b = raw_bin(src[i]);
+							if (b < bins)
+								sycl::atomic_ref<std::uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device,
+									sycl::access::address_space::global_space>{counts[b]}.fetch_add(1);
+						}
+					}
+				);
+			}
+		}
+	);
+}
+
+} // namespace samples
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Time to first kernel with and without a prebuilt, cached kernel bundle (see kernel-cache.hpp).
+//
+//	kernel-cache --clear      empty the cache, then a cold start
+//	kernel-cache              a warm start once the cache is filled
+//	kernel-cache --lazy       no prebuild and no persistent cache: the kernel compiles at its submit
+//
+// The time to first kernel runs from the start of main to the end of the first kernel, and
+// is split into queue creation, prebuild and the first submit. The program holds a vector
+// add, the tiled gemm and vec-math kernels, so there is something to compile.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "gemm.hpp"
+#include "kernel-cache.hpp"
+#include "vec-math.hpp"
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+class cache_vector_add_kernel;
+
+int main(int argc, char * argv[])
+{
+	const auto start = std::chrono::steady_clock::now();
+	auto since = [] (std::chrono::steady_clock::time_point from)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-from).count();
+	};
+
+	bool lazy = false;
+	for (int i=1; i<argc; i++)
+	{
+		const std::string_view arg{argv[i]};
+		if (arg == "--clear")
+			samples::kernel_cache::clear();
+		else if (arg == "--lazy")
+			lazy = true;
+		else
+			utx::printe("unknown option:", arg);
+	}
+	const bool cold = samples::kernel_cache::empty();
+	if (! lazy)
+		samples::kernel_cache::persist();
+
+	auto step = std::chrono::steady_clock::now();
+	sycl::queue queue{sycl::gpu_selector_v};
+	const double queue_ms = since(step);
+
+	step = std::chrono::steady_clock::now();
+	std::optional<sycl::kernel_bundle<sycl::bundle_state::executable>> bundle;
+	if (! lazy)
+		bundle = samples::kernel_cache::prebuild(queue);
+	const double prebuild_ms = since(step);
+
+	constexpr std::size_t size = 1024;
+	utx::fc32 * x = sycl::malloc_shared<utx::fc32>(size, queue);
+	utx::fc32 * y = sycl::malloc_shared<utx::fc32>(size, queue);
+	for (std::size_t i=0; i<size; i++)
+	{
+		x[i] = static_cast<float>(i);
+		y[i] = 1.0f;
+	}
+
+	step = std::chrono::steady_clock::now();
+	queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			if (bundle)
+				handler.use_kernel_bundle(*bundle);
+			handler.parallel_for<cache_vector_add_kernel>(
+				sycl::range<1>{size},
+				[=] (sycl::id<1> id)
+				{
+					y[id] = x[id] + y[id];
+				}
+			);
+		}
+	).wait();
+	const double first_ms = since(step);
+	const double total_ms = since(start);
+
+	// The other kernels of the program are plain submits without use_kernel_bundle, so they
+	// do not run from the prebuilt bundle: they compile at their submit, or load from the
+	// persistent cache when it holds them.
+	step = std::chrono::steady_clock::now();
+	samples::gemm(queue, x, x, y, 32, 32, 1).wait();
+	samples::vec_math::apply<samples::vec_math::sqrt_op, 8>(queue, x, y, size).wait();
+	const double others_ms = since(step);
+
+	utx::print(
+		lazy ? "lazy" : cold ? "cold" : "warm",
+		"queue ms:", queue_ms,
+		"prebuild ms:", prebuild_ms,
+		"first kernel ms:", first_ms,
+		"time to first kernel ms:", total_ms,
+		"gemm + vec-math (not prebuilt) ms:", others_ms
+	);
+
+	sycl::free(x, queue);
+	sycl::free(y, queue);
+	return 0;
+}
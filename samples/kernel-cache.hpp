@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::kernel_cache: build the kernels of a program at startup, once per machine.
+//
+//	samples::kernel_cache::persist(); // before the first sycl object
+//	sycl::queue queue{sycl::gpu_selector_v};
+//	auto bundle = samples::kernel_cache::prebuild(queue);
+//	queue.submit([&] (sycl::handler & handler) { handler.use_kernel_bundle(bundle); ... });
+//
+// prebuild takes the input bundle of the device with sycl::get_kernel_bundle and compiles
+// every kernel with sycl::build, instead of compiling each one lazily at its first submit.
+// Kernels compiled ahead of time have no input state and come back as they are.
+//
+// SYCL 2020 has no call to save a built bundle, so persist turns on the persistent program
+// cache of the implementation instead (SYCL_CACHE_PERSISTENT and SYCL_CACHE_DIR on DPC++;
+// AdaptiveCpp always caches). The runtime reads these when it starts, so persist has to run
+// before any queue, device or platform is created. Variables already set are kept.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace samples::kernel_cache
+{
+
+// $SYCL_CACHE_DIR, else $XDG_CACHE_HOME/utxcpp-sycl-samples, else ~/.cache/utxcpp-sycl-samples
+inline std::filesystem::path default_directory()
+{
+	if (const char * dir = std::getenv("SYCL_CACHE_DIR"); dir && *dir)
+		return dir;
+	if (const char * dir = std::getenv("XDG_CACHE_HOME"); dir && *dir)
+		return std::filesystem::path{dir} / "utxcpp-sycl-samples";
+	if (const char * home = std::getenv("HOME"); home && *home)
+		return std::filesystem::path{home} / ".cache" / "utxcpp-sycl-samples";
+	return std::filesystem::temp_directory_path() / "utxcpp-sycl-samples";
+}
+
+// true when the cache directory holds no file yet, so the next build is a cold one
+inline bool empty(const std::filesystem::path & dir = default_directory())
+{
+	std::error_code error;
+	for (auto it = std::filesystem::recursive_directory_iterator{dir, error};
+		! error && it != std::filesystem::recursive_directory_iterator{}; it.increment(error))
+		if (it->is_regular_file(error))
+			return false;
+	return true;
+}
+
+inline void clear(const std::filesystem::path & dir = default_directory())
+{
+	std::error_code error;
+	std::filesystem::remove_all(dir, error);
+}
+
+inline void persist(const std::filesystem::path & dir = default_directory())
+{
+	std::error_code error;
+	std::filesystem::create_directories(dir, error);
+	::setenv("SYCL_CACHE_PERSISTENT", "1", 0);
+	::setenv("SYCL_CACHE_DIR", dir.c_str(), 0);
+}
+
+inline sycl::kernel_bundle<sycl::bundle_state::executable> prebuild(
+	const sycl::context & context, const std::vector<sycl::device> & devices)
+{
+	if (sycl::has_kernel_bundle<sycl::bundle_state::input>(context, devices))
+		return sycl::build(sycl::get_kernel_bundle<sycl::bundle_state::input>(context, devices));
+	return sycl::get_kernel_bundle<sycl::bundle_state::executable>(context, devices);
+}
+
+// every kernel of the program, built for the device of queue
+inline sycl::kernel_bundle<sycl::bundle_state::executable> prebuild(const sycl::queue & queue)
+{
+	return prebuild(queue.get_context(), {queue.get_device()});
+}
+
+// only the kernels named kernel_names...
+template <typename ... kernel_names>
+sycl::kernel_bundle<sycl::bundle_state::executable> prebuild(const sycl::queue & queue)
+	requires (sizeof...(kernel_names) > 0)
+{
+	const std::vector<sycl::kernel_id> ids{sycl::get_kernel_id<kernel_names>()...};
+	const sycl::context context = queue.get_context();
+	const std::vector<sycl::device> devices{queue.get_device()};
+	if (sycl::has_kernel_bundle<sycl::bundle_state::input>(context, devices, ids))
+		return sycl::build(sycl::get_kernel_bundle<sycl::bundle_state::input>(context, devices, ids));
+	return sycl::get_kernel_bundle<sycl::bundle_state::executable>(context, devices, ids);
+}
+
+} // namespace samples::kernel_cache
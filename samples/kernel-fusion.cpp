@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Fused and unfused elementwise pipelines (see fusion.hpp).
+//
+//	kernel-fusion --size=16777216 --warmup=2 --repeat=10 --format=csv
+//
+//	out = sqrt(sin(x)) * y + z    fused: 1 kernel,  3 reads + 1 write per element
+//	                              unfused: 4 kernels, 6 reads + 4 writes per element
+//	out = cbrt(x * y) + z         fused: 1 kernel,  unfused: 3 kernels
+//
+// Both outputs are checked against a double precision host reference, to 16 ulp of the
+// expected value.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include "bench.hpp"
+#include "fusion.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <string>
+#include <vector>
+
+namespace fusion = samples::fusion;
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+
+	const std::size_t size = opts.size;
+	const std::size_t bytes = size*sizeof(utx::fc32);
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	std::vector<utx::fc32> host_x(size), host_y(size), host_z(size);
+	for (std::size_t i=0; i<size; i++)
+	{
+		host_x[i] = (i%1000)*std::numbers::pi_v<float>/1000;
+		host_y[i] = 1.0f + (i%7);
+		host_z[i] = 0.5f*(i%13);
+	}
+
+	auto px = samples::make_pooled<utx::fc32>(pool, size);
+	auto py = samples::make_pooled<utx::fc32>(pool, size);
+	auto pz = samples::make_pooled<utx::fc32>(pool, size);
+	auto fused_out = samples::make_pooled<utx::fc32>(pool, size);
+	auto unfused_out = samples::make_pooled<utx::fc32>(pool, size);
+	auto t1 = samples::make_pooled<utx::fc32>(pool, size);
+	auto t2 = samples::make_pooled<utx::fc32>(pool, size);
+	queue.memcpy(px.get(), host_x.data(), bytes);
+	queue.memcpy(py.get(), host_y.data(), bytes);
+	queue.memcpy(pz.get(), host_z.data(), bytes);
+	queue.wait();
+
+	const auto x = fusion::arg(static_cast<const utx::fc32 *>(px.get()));
+	const auto y = fusion::arg(static_cast<const utx::fc32 *>(py.get()));
+	const auto z = fusion::arg(static_cast<const utx::fc32 *>(pz.get()));
+	const auto a = fusion::arg(static_cast<const utx::fc32 *>(t1.get()));
+	const auto b = fusion::arg(static_cast<const utx::fc32 *>(t2.get()));
+
+	// fused and unfused output against want(i), within 16 ulp of it
+	auto check = [&] (const std::string & name, auto want)
+	{
+		std::vector<utx::fc32> fused(size), unfused(size);
+		queue.memcpy(fused.data(), fused_out.get(), bytes);
+		queue.memcpy(unfused.data(), unfused_out.get(), bytes).wait();
+		double diff = 0;
+		std::size_t errors = 0;
+		for (std::size_t i=0; i<size; i++)
+		{
+			const double expected = want(i);
+			const double tolerance = 16*std::numeric_limits<float>::epsilon()*std::max(std::abs(expected), 1e-3);
+			if (! (std::abs(fused[i]() - expected) <= tolerance && std::abs(unfused[i]() - expected) <= tolerance))
+				errors++;
+			diff = std::max(diff, std::abs(static_cast<double>(fused[i]()) - unfused[i]()));
+		}
+		utx::printe(name, "max |fused - unfused|:", diff);
+		if (errors)
+			utx::printe(name, "FAILED, errors:", errors);
+		return errors == 0;
+	};
+
+	// sqrt(sin(x)) * y + z
+	report(samples::bench::run(opts, "sqrt-sin-mul-add-fused", "fc32", size, 4.0*bytes, 4.0*size,
+		[&]
+		{
+			return fusion::assign(queue, fused_out.get(), fusion::sqrt(fusion::sin(x)) * y + z, size);
+		}
+	));
+	report(samples::bench::run(opts, "sqrt-sin-mul-add-unfused", "fc32", size, 10.0*bytes, 4.0*size,
+		[&]
+		{
+			std::vector<sycl::event> events;
+			events.push_back(fusion::assign(queue, t1.get(), fusion::sin(x), size));
+			events.push_back(fusion::assign(queue, t2.get(), fusion::sqrt(a), size, {events.back()}));
+			events.push_back(fusion::assign(queue, t1.get(), b * y, size, {events.back()}));
+			events.push_back(fusion::assign(queue, unfused_out.get(), a + z, size, {events.back()}));
+			return events;
+		}
+	));
+	bool ok = check("sqrt-sin-mul-add",
+		[&] (std::size_t i)
+		{
+			return std::sqrt(std::sin(static_cast<double>(host_x[i]()))) * host_y[i]() + host_z[i]();
+		}
+	);
+
+	// cbrt(x * y) + z
+	report(samples::bench::run(opts, "cbrt-mul-add-fused", "fc32", size, 4.0*bytes, 3.0*size,
+		[&]
+		{
+			return fusion::assign(queue, fused_out.get(), fusion::cbrt(x * y) + z, size);
+		}
+	));
+	report(samples::bench::run(opts, "cbrt-mul-add-unfused", "fc32", size, 8.0*bytes, 3.0*size,
+		[&]
+		{
+			std::vector<sycl::event> events;
+			events.push_back(fusion::assign(queue, t1.get(), x * y, size));
+			events.push_back(fusion::assign(queue, t2.get(), fusion::cbrt(a), size, {events.back()}));
+			events.push_back(fusion::assign(queue, unfused_out.get(), b + z, size, {events.back()}));
+			return events;
+		}
+	));
+	ok = check("cbrt-mul-add",
+		[&] (std::size_t i)
+		{
+			return std::cbrt(static_cast<double>(host_x[i]()) * host_y[i]()) + host_z[i]();
+		}
+	) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::launch: nd_range launches of any extent.
+//
+//	samples::launch::masked<class my_kernel>(queue, sycl::range<1>{10'000'003}, body);
+//	samples::launch::grid_stride<class my_kernel>(queue, sycl::range<2>{rows, cols}, body);
+//
+// body(sycl::id<dims>) is called once for every id inside the extent, however the extent
+// divides into work-groups:
+//	masked       rounds the global range up to a multiple of the local range, and the items
+//	             past the extent return at once.
+//	grid_stride  launches a fixed number of work-groups (a few per compute unit), and every
+//	             item walks the extent in steps of the global range.
+// local_range picks the work-group shape from the device: a multiple of its widest
+// sub-group, and 32 items along the last dimension so rows stay coalesced.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "tuner.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace samples::launch
+{
+
+// preferred, capped by the device and rounded down to a multiple of its widest sub-group
+inline std::size_t work_group_size(const sycl::device & device, std::size_t preferred = 256)
+{
+	const device_caps & caps = capabilities(device);
+	std::size_t size = std::min(preferred, caps.max_work_group_size);
+	if (! caps.sub_group_sizes.empty() && size >= caps.sub_group_sizes.back())
+		size = size/caps.sub_group_sizes.back()*caps.sub_group_sizes.back();
+	return std::max<std::size_t>(size, 1);
+}
+
+// a work-group shape for extent, no larger than extent in any dimension
+template <int dims>
+sycl::range<dims> local_range(const sycl::device & device, const sycl::range<dims> & extent, std::size_t preferred = 256)
+{
+	const std::size_t size = work_group_size(device, preferred);
+	sycl::range<dims> local = extent;
+	if constexpr (dims == 1)
+		local[0] = size;
+	else
+	{
+		const std::size_t inner = std::min<std::size_t>(size, 32);
+		if constexpr (dims == 2)
+		{
+			local[0] = size/inner;
+			local[1] = inner;
+		}
+		else
+		{
+			const std::size_t middle = std::min<std::size_t>(size/inner, 4);
+			local[0] = size/inner/middle;
+			local[1] = middle;
+			local[2] = inner;
+		}
+	}
+	for (int d=0; d<dims; d++)
+		local[d] = std::max<std::size_t>(std::min(local[d], extent[d]), 1);
+	return local;
+}
+
+// the id of linear index i in extent, row-major
+template <int dims>
+sycl::id<dims> delinearize(std::size_t i, const sycl::range<dims> & extent)
+{
+	if constexpr (dims == 1)
+		return sycl::id<1>{i};
+	else if constexpr (dims == 2)
+		return sycl::id<2>{i/extent[1], i%extent[1]};
+	else
+		return sycl::id<3>{i/(extent[1]*extent[2]), i/extent[2]%extent[1], i%extent[2]};
+}
+
+template <typename kernel_name>
+class masked_kernel;
+
+template <typename kernel_name>
+class grid_stride_kernel;
+
+template <typename kernel_name, int dims, typename body_type>
+void masked(sycl::handler & handler, const sycl::range<dims> & extent, const sycl::range<dims> & local, body_type body)
+{
+	sycl::range<dims> global = extent;
+	for (int d=0; d<dims; d++)
+		global[d] = round_up(extent[d], local[d]);
+	handler.parallel_for<masked_kernel<kernel_name>>(
+		sycl::nd_range<dims>{global, local},
+		[=] (sycl::nd_item<dims> item)
+		{
+			const sycl::id<dims> id = item.get_global_id();
+			for (int d=0; d<dims; d++)
+				if (id[d] >= extent[d])
+					return;
+			body(id);
+		}
+	);
+}
+
+template <typename kernel_name, int dims, typename body_type>
+void grid_stride(sycl::handler & handler, const sycl::range<dims> & extent, std::size_t local, std::size_t groups,
+	body_type body)
+{
+	const std::size_t total = extent.size();
+	groups = std::max<std::size_t>(std::min(groups, (total+local-1)/local), 1);
+	handler.parallel_for<grid_stride_kernel<kernel_name>>(
+		sycl::nd_range<1>{sycl::range<1>{groups*local}, sycl::range<1>{local}},
+		[=] (sycl::nd_item<1> item)
+		{
+			for (std::size_t i=item.get_global_id(0); i<total; i+=item.get_global_range(0))
+				body(delinearize(i, extent));
+		}
+	);
+}
+
+template <typename kernel_name, int dims, typename body_type>
+sycl::event masked(
+	sycl::queue & queue,
+	const sycl::range<dims> & extent,
+	body_type body,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	const sycl::range<dims> local = local_range(queue.get_device(), extent);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			masked<kernel_name>(handler, extent, local, body);
+		}
+	);
+}
+
+// groups_per_unit work-groups per compute unit
+template <typename kernel_name, int dims, typename body_type>
+sycl::event grid_stride(
+	sycl::queue & queue,
+	const sycl::range<dims> & extent,
+	body_type body,
+	const std::vector<sycl::event> & deps = {},
+	std::size_t groups_per_unit = 4
+)
+{
+	const sycl::device device = queue.get_device();
+	const std::size_t local = work_group_size(device);
+	const std::size_t groups = groups_per_unit*capabilities(device).compute_units;
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			grid_stride<kernel_name>(handler, extent, local, groups, body);
+		}
+	);
+}
+
+} // namespace samples::launch
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::layout: AoS <-> SoA <-> AoSoA transforms for small vector types
+// such as uflat::vector4uc32.
+//
+//	AoS    aos[i][c]                               (the uflat vectors as they are)
+//	SoA    soa[c*n + i]                            (one array per component)
+//	AoSoA  aosoa[((i/w)*components + c)*w + i%w]   (blocks of w elements per component)
+//
+// The SoA and AoSoA forms hold the raw component type (utx::u32 for utx::uc32),
+// so a kernel can load w consecutive lanes of one component into a native_simd.
+// AoSoA is padded to a multiple of w elements with zeros.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace samples::layout
+{
+
+template <typename vector_type>
+using component_t = std::remove_cvref_t<decltype(std::declval<vector_type &>()[0])>;
+
+template <typename vector_type>
+using lane_t = raw_value_t<component_t<vector_type>>;
+
+template <typename vector_type>
+constexpr std::size_t components_v = sizeof(vector_type)/sizeof(component_t<vector_type>);
+
+// elements of an AoSoA buffer holding n vectors in blocks of width
+template <typename vector_type>
+std::size_t aosoa_size(std::size_t n, std::size_t width)
+{
+	return round_up(n, width)*components_v<vector_type>;
+}
+
+template <typename vector_type, int kind>
+class layout_kernel;
+
+template <typename vector_type>
+sycl::event aos_to_soa(
+	sycl::queue & queue,
+	sycl::buffer<vector_type, 1> & aos,
+	sycl::buffer<lane_t<vector_type>, 1> & soa
+)
+{
+	constexpr std::size_t components = components_v<vector_type>;
+	const std::size_t n = aos.size();
+	if (soa.size() < components*n)
+		throw std::invalid_argument{"samples::layout::aos_to_soa: soa buffer is too small"};
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			auto src = sycl::accessor{aos, handler, sycl::read_only};
+			auto dst = sycl::accessor{soa, handler, sycl::write_only, sycl::no_init};
+			handler.parallel_for<layout_kernel<vector_type, 0>>(
+				sycl::range<2>{components, n},
+				[=] (sycl::id<2> id)
+				{
+					const std::size_t c = id[0], i = id[1];
+					dst[c*n+i] = to_raw(src[i][c]);
+				}
+			);
+		}
+	);
+}
+
+template <typename vector_type>
+sycl::event soa_to_aos(
+	sycl::queue & queue,
+	sycl::buffer<lane_t<vector_type>, 1> & soa,
+	sycl::buffer<vector_type, 1> & aos
+)
+{
+	constexpr std::size_t components = components_v<vector_type>;
+	const std::size_t n = aos.size();
+	if (soa.size() < components*n)
+		throw std::invalid_argument{"samples::layout::soa_to_aos: soa buffer is too small"};
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			auto src = sycl::accessor{soa, handler, sycl::read_only};
+			auto dst = sycl::accessor{aos, handler, sycl::write_only, sycl::no_init};
+			handler.parallel_for<layout_kernel<vector_type, 1>>(
+				sycl::range<1>{n},
+				[=] (sycl::id<1> id)
+				{
+					const std::size_t i = id[0];
+					vector_type v;
+					for (std::size_t c=0; c<components; c++)
+						v[c] = component_t<vector_type>(src[c*n+i]);
+					dst[i] = v;
+				}
+			);
+		}
+	);
+}
+
+template <typename vector_type>
+sycl::event aos_to_aosoa(
+	sycl::queue & queue,
+	sycl::buffer<vector_type, 1> & aos,
+	sycl::buffer<lane_t<vector_type>, 1> & aosoa,
+	std::size_t width
+)
+{
+	constexpr std::size_t components = components_v<vector_type>;
+	const std::size_t n = aos.size();
+	const std::size_t padded = round_up(n, width);
+	if (aosoa.size() < aosoa_size<vector_type>(n, width))
+		throw std::invalid_argument{"samples::layout::aos_to_aosoa: aosoa buffer is too small"};
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			auto src = sycl::accessor{aos, handler, sycl::read_only};
+			auto dst = sycl::accessor{aosoa, handler, sycl::write_only, sycl::no_init};
+			handler.parallel_for<layout_kernel<vector_type, 2>>(
+				sycl::range<2>{components, padded},
+				[=] (sycl::id<2> id)
+				{
+					const std::size_t c = id[0], i = id[1];
+					dst[((i/width)*components + c)*width + i%width] =
+						i < n ? to_raw(src[i][c]) : lane_t<vector_type>(0);
+				}
+			);
+		}
+	);
+}
+
+template <typename vector_type>
+sycl::event aosoa_to_aos(
+	sycl::queue & queue,
+	sycl::buffer<lane_t<vector_type>, 1> & aosoa,
+	sycl::buffer<vector_type, 1> & aos,
+	std::size_t width
+)
+{
+	constexpr std::size_t components = components_v<vector_type>;
+	const std::size_t n = aos.size();
+	if (aosoa.size() < aosoa_size<vector_type>(n, width))
+		throw std::invalid_argument{"samples::layout::aosoa_to_aos: aosoa buffer is too small"};
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			auto src = sycl::accessor{aosoa, handler, sycl::read_only};
+			auto dst = sycl::accessor{aos, handler, sycl::write_only, sycl::no_init};
+			handler.parallel_for<layout_kernel<vector_type, 3>>(
+				sycl::range<1>{n},
+				[=] (sycl::id<1> id)
+				{
+					const std::size_t i = id[0];
+					vector_type v;
+					for (std::size_t c=0; c<components; c++)
+						v[c] = component_t<vector_type>(src[((i/width)*components + c)*width + i%width]);
+					dst[i] = v;
+				}
+			);
+		}
+	);
+}
+
+} // namespace samples::layout
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::sparse::read_matrix_market: Matrix Market coordinate files to csr.
+//
+//	%%MatrixMarket matrix coordinate real|integer|pattern general|symmetric|skew-symmetric
+//	% comments
+//	rows cols entries
+//	row col [value]      (1-based)
+//
+// Pattern entries are 1, symmetric and skew-symmetric files are expanded to both triangles.
+
+#pragma once
+
+#include "sparse.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples::sparse
+{
+
+template <typename data_type>
+csr_host<data_type> read_matrix_market(const std::string & path)
+{
+	using raw_type = raw_value_t<data_type>;
+	std::ifstream file{path};
+	if (! file)
+		throw std::runtime_error{"samples::sparse::read_matrix_market: cannot open " + path};
+
+	std::string line;
+	std::getline(file, line);
+	std::transform(line.begin(), line.end(), line.begin(),
+		[] (unsigned char c)
+		{
+			return std::tolower(c);
+		}
+	);
+	std::istringstream banner{line};
+	std::string tag, object, format, field, symmetry;
+	banner >> tag >> object >> format >> field >> symmetry;
+	if (tag != "%%matrixmarket" || object != "matrix" || format != "coordinate")
+		throw std::runtime_error{"samples::sparse::read_matrix_market: not a coordinate matrix " + path};
+	if (field != "real" && field != "integer" && field != "pattern")
+		throw std::runtime_error{"samples::sparse::read_matrix_market: unsupported field " + field};
+	if (symmetry != "general" && symmetry != "symmetric" && symmetry != "skew-symmetric")
+		throw std::runtime_error{"samples::sparse::read_matrix_market: unsupported symmetry " + symmetry};
+	const bool pattern = field == "pattern";
+	const bool mirrored = symmetry != "general";
+	const raw_type mirror_sign = symmetry == "skew-symmetric" ? raw_type(-1) : raw_type(1);
+
+	while (std::getline(file, line) && (line.empty() || line[0] == '%'))
+		;
+	std::size_t rows = 0, cols = 0, entries = 0;
+	if (! (std::istringstream{line} >> rows >> cols >> entries))
+		throw std::runtime_error{"samples::sparse::read_matrix_market: bad size line in " + path};
+
+	std::vector<index_type> row, col;
+	std::vector<data_type> value;
+	row.reserve(mirrored ? 2*entries : entries);
+	col.reserve(row.capacity());
+	value.reserve(row.capacity());
+	for (std::size_t e=0; e<entries; e++)
+	{
+		std::size_t r, c;
+		double v = 1;
+		if (! (file >> r >> c) || (! pattern && ! (file >> v)) || r < 1 || c < 1)
+			throw std::runtime_error{"samples::sparse::read_matrix_market: bad entry in " + path};
+		row.push_back(r-1);
+		col.push_back(c-1);
+		value.push_back(data_type(static_cast<raw_type>(v)));
+		if (mirrored && r != c)
+		{
+			row.push_back(c-1);
+			col.push_back(r-1);
+			value.push_back(data_type(mirror_sign*static_cast<raw_type>(v)));
+		}
+	}
+	return from_triplets(rows, cols, std::move(row), std::move(col), std::move(value));
+}
+
+} // namespace samples::sparse
@@ -5,14 +5,115 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 
+// Tiled, register-blocked matrix multiply (samples::gemm, see gemm.hpp).
+//
+//	matrix-mul           : 4x4 demo, then check ic32, fc32 and fc64 on a set of odd sizes.
+//	matrix-mul M N K     : check M x K by K x N against the naive host reference.
+
 #include <sycl/sycl.hpp>
 #include <utxcpp/core.hpp>
 #include <utxcpp/algorithm.hpp>
+#include "gemm.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <type_traits>
+
+template <typename data_type>
+void gemm_reference(
+	const std::vector<data_type> & a,
+	const std::vector<data_type> & b,
+	std::vector<data_type> & c,
+	std::size_t m, std::size_t n, std::size_t k
+)
+{
+	std::fill(c.begin(), c.end(), data_type(0));
+	for (std::size_t i=0; i<m; i++)
+		for (std::size_t p=0; p<k; p++)
+		{
+			const data_type aip = a[i*k+p];
+			for (std::size_t j=0; j<n; j++)
+				c[i*n+j] += aip * b[p*n+j];
+		}
+}
+
+template <typename data_type>
+bool check_gemm(sycl::queue & queue, std::size_t m, std::size_t n, std::size_t k, const char * name)
+{
+	std::mt19937 gen{static_cast<std::mt19937::result_type>(m*131+n*31+k)};
+	std::vector<data_type> a(m*k), b(k*n), c(m*n), ref(m*n);
+	auto fill = [&gen] (std::vector<data_type> & mat)
+	{
+		if constexpr (std::is_same_v<data_type, utx::ic32>)
+		{
+			std::uniform_int_distribution<int> dist{-4, 4};
+			for (auto & x: mat)
+				x = data_type(dist(gen));
+		}
+		else
+		{
+			std::uniform_real_distribution<double> dist{-1.0, 1.0};
+			for (auto & x: mat)
+				x = data_type(dist(gen));
+		}
+	};
+	fill(a);
+	fill(b);
+
+	double seconds = 0;
+	{
+		sycl::buffer<data_type, 2> buff_a{a.data(), sycl::range<2>{m, k}};
+		sycl::buffer<data_type, 2> buff_b{b.data(), sycl::range<2>{k, n}};
+		sycl::buffer<data_type, 2> buff_c{c.data(), sycl::range<2>{m, n}};
+
+		samples::gemm(queue, buff_a, buff_b, buff_c).wait(); // warm-up, includes JIT and transfers
+		auto start = std::chrono::steady_clock::now();
+		samples::gemm(queue, buff_a, buff_b, buff_c).wait();
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+	}
+
+	gemm_reference(a, b, ref, m, n, k);
+
+	// integers must match exactly, floating point is allowed the usual k*eps growth
+	const double tol = std::is_same_v<data_type, utx::ic32> ? 0.0 :
+		std::is_same_v<data_type, utx::fc32> ? 1e-6*k : 1e-14*k;
+	std::size_t errors = 0;
+	for (std::size_t i=0; i<m*n; i++)
+	{
+		const double got = c[i](), want = ref[i]();
+		if (std::abs(got-want) > tol*(1.0+std::abs(want)))
+			errors++;
+	}
+
+	const double gflops = 2.0*m*n*k/seconds*1e-9;
+	utx::print(name, m, 'x', n, 'x', k, errors==0 ? "ok" : "FAILED", "errors:", errors, "GFLOP/s:", gflops);
+	return errors == 0;
+}
+
+bool check_all(sycl::queue & queue, std::size_t m, std::size_t n, std::size_t k)
+{
+	bool ok = check_gemm<utx::ic32>(queue, m, n, k, "ic32");
+	ok = check_gemm<utx::fc32>(queue, m, n, k, "fc32") && ok;
+	if (queue.get_device().has(sycl::aspect::fp64))
+		ok = check_gemm<utx::fc64>(queue, m, n, k, "fc64") && ok;
+	return ok;
+}
 
-int main()
+int main(int argc, char * argv[])
 {
 	sycl::queue queue{sycl::gpu_selector_v};
 
+	if (argc == 4)
+	{
+		const std::size_t m = std::strtoull(argv[1], nullptr, 10);
+		const std::size_t n = std::strtoull(argv[2], nullptr, 10);
+		const std::size_t k = std::strtoull(argv[3], nullptr, 10);
+		return check_all(queue, m, n, k) ? 0 : 1;
+	}
+
 	std::vector<utx::ic32>
 		mat1 =
 			{
@@ -35,46 +136,7 @@ int main()
 	auto buff2 = new sycl::buffer<utx::ic32, 2>{mat2.data(), sycl::range<2>{4,4}};
 	auto buff3 = new sycl::buffer<utx::ic32, 2>{mat3.data(), sycl::range<2>{4,4}};
 
-	queue.submit(
-		[&] (sycl::handler & handler)
-		{
-			auto acc1 = buff1->get_access<sycl::access_mode::read>(handler);
-			auto acc2 = buff2->get_access<sycl::access_mode::read>(handler);
-			auto acc3 = buff3->get_access<sycl::access_mode::write>(handler);
-			auto lm = sycl::local_accessor<utx::ic32, 2>{sycl::range<2>{2,2}, handler};
-			handler.parallel_for<class kernel_matrix_mul>(
-				sycl::nd_range<2>{
-					sycl::range<2>{4,4},
-					sycl::range<2>{2,2}
-				},
-				[=] (sycl::nd_item<2> item)
-				{
-					utx::uc32 gid0 = item.get_global_id(0);
-					utx::uc32 gid1 = item.get_global_id(1);
-
-					utx::uc32 side = item.get_global_range(0); // 4
-					//utx::uc32 side = item.get_global_range(1); // 4
-
-					utx::uc32 lid0 = item.get_local_id(0);
-					utx::uc32 lid1 = item.get_local_id(1);
-
-					// name shorter alias
-					utx::ic32 & lmr = lm[lid0][lid1];
-
-					lmr = 0;
-					sycl::group_barrier(item.get_group());
-
-					for (utx::uc32 ij=0; ij<side; ij++)
-					{
-						lmr += acc1[gid0][ij] * acc2[ij][gid1];
-						sycl::group_barrier(item.get_group());
-					}
-
-					acc3[gid0][gid1] = lmr;
-				}
-			);
-		}
-	);
+	samples::gemm(queue, *buff1, *buff2, *buff3);
 
 	delete buff1;
 	delete buff2;
@@ -97,5 +159,11 @@ int main()
 	print_matrix(mat2);
 	utx::print("=");
 	print_matrix(mat3);
-}
 
+	bool ok = true;
+	for (auto [m, n, k]: std::vector<std::array<std::size_t, 3>>{
+		{1, 1, 1}, {17, 33, 9}, {64, 64, 64}, {255, 129, 300}, {1000, 1000, 1000}
+	})
+		ok = check_all(queue, m, n, k) && ok;
+	return ok ? 0 : 1;
+}
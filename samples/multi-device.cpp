@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// vector-add and matrix-mul split over 1, 2, ... partitions (see partition.hpp).
+//
+//	multi-device --cpu --size=67108864 --gemm-size=2048     NUMA sub-devices of the cpu
+//	multi-device --devices                                  every device of the same type
+//
+// Every partition first-touches its slab of the inputs and outputs; matrix-mul splits the
+// rows of A and C and gives every partition its own copy of B. The kernels of all partitions
+// run at once, so the time is host time from the first submit to the last wait.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "gemm.hpp"
+#include "partition.hpp"
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace partition = samples::partition;
+
+class vector_add_kernel;
+
+// (i % period) / period - 0.5
+struct pattern
+{
+	std::size_t period;
+
+	utx::fc32 operator()(std::size_t i) const
+	{
+		return static_cast<float>(i%period)/static_cast<float>(period) - 0.5f;
+	}
+};
+
+bool vector_add(const std::vector<sycl::device> & devices, const samples::bench::options & opts,
+	samples::bench::reporter & report)
+{
+	partition::group parts{devices};
+	const std::size_t size = opts.size;
+	const auto slices = partition::split(sycl::range<1>{size}, parts.size());
+
+	std::vector<samples::pooled_ptr<utx::fc32>> a, b, c;
+	for (std::size_t p=0; p<slices.size(); p++)
+	{
+		const std::size_t count = slices[p].range[0], offset = slices[p].offset[0];
+		a.push_back(samples::make_pooled<utx::fc32>(parts.pool(p), count));
+		b.push_back(samples::make_pooled<utx::fc32>(parts.pool(p), count));
+		c.push_back(samples::make_pooled<utx::fc32>(parts.pool(p), count));
+		partition::first_touch(parts.queue(p), a[p].get(), count, offset, pattern{7});
+		partition::first_touch(parts.queue(p), b[p].get(), count, offset, pattern{11});
+		partition::first_touch(parts.queue(p), c[p].get(), count, offset, pattern{1});
+	}
+	parts.wait();
+
+	report(samples::bench::run_host(opts, "vector-add-parts-" + std::to_string(parts.size()), "fc32", size,
+		3.0*size*sizeof(utx::fc32), size,
+		[&]
+		{
+			for (std::size_t p=0; p<slices.size(); p++)
+			{
+				const utx::fc32 * x = a[p].get();
+				const utx::fc32 * y = b[p].get();
+				utx::fc32 * z = c[p].get();
+				parts.queue(p).parallel_for<vector_add_kernel>(
+					slices[p].range,
+					[=] (sycl::id<1> id)
+					{
+						z[id] = x[id] + y[id];
+					}
+				);
+			}
+			parts.wait();
+		}
+	));
+
+	for (std::size_t p=0; p<slices.size(); p++)
+	{
+		const std::size_t count = slices[p].range[0], offset = slices[p].offset[0];
+		std::vector<utx::fc32> host(count);
+		parts.queue(p).memcpy(host.data(), c[p].get(), count*sizeof(utx::fc32)).wait();
+		for (std::size_t i=0; i<count; i++)
+			if (host[i]() != pattern{7}(offset+i)() + pattern{11}(offset+i)())
+			{
+				utx::printe("vector-add FAILED at", offset+i);
+				return false;
+			}
+	}
+	return true;
+}
+
+bool matrix_mul(const std::vector<sycl::device> & devices, const samples::bench::options & opts,
+	samples::bench::reporter & report)
+{
+	partition::group parts{devices};
+	const std::size_t m = opts.gemm_size, n = opts.gemm_size, k = opts.gemm_size;
+	const auto slices = partition::split(sycl::range<2>{m, n}, parts.size(), samples::gemm_tile<>::tile);
+
+	std::vector<samples::pooled_ptr<utx::fc32>> a, b, c;
+	for (std::size_t p=0; p<slices.size(); p++)
+	{
+		const std::size_t rows = slices[p].range[0], row = slices[p].offset[0];
+		a.push_back(samples::make_pooled<utx::fc32>(parts.pool(p), rows*k));
+		b.push_back(samples::make_pooled<utx::fc32>(parts.pool(p), k*n));
+		c.push_back(samples::make_pooled<utx::fc32>(parts.pool(p), rows*n));
+		partition::first_touch(parts.queue(p), a[p].get(), rows*k, row*k, pattern{7});
+		partition::first_touch(parts.queue(p), b[p].get(), k*n, 0, pattern{11});
+		partition::first_touch(parts.queue(p), c[p].get(), rows*n, row*n, pattern{1});
+	}
+	parts.wait();
+
+	report(samples::bench::run_host(opts, "matrix-mul-parts-" + std::to_string(parts.size()), "fc32", m,
+		(m*k + k*n*slices.size() + m*n)*sizeof(utx::fc32), 2.0*m*n*k,
+		[&]
+		{
+			for (std::size_t p=0; p<slices.size(); p++)
+				samples::gemm(parts.queue(p), a[p].get(), b[p].get(), c[p].get(), slices[p].range[0], n, k);
+			parts.wait();
+		}
+	));
+
+	// every 97th row against a double precision host product
+	for (std::size_t p=0; p<slices.size(); p++)
+	{
+		const std::size_t rows = slices[p].range[0], row = slices[p].offset[0];
+		std::vector<utx::fc32> host(rows*n);
+		parts.queue(p).memcpy(host.data(), c[p].get(), rows*n*sizeof(utx::fc32)).wait();
+		for (std::size_t i=(97-row%97)%97; i<rows; i+=97)
+			for (std::size_t j=0; j<n; j++)
+			{
+				double want = 0;
+				for (std::size_t q=0; q<k; q++)
+					want += static_cast<double>(pattern{7}((row+i)*k+q)()) * pattern{11}(q*n+j)();
+				if (std::abs(host[i*n+j]() - want) > 1e-5*k*(1+std::abs(want)))
+				{
+					utx::printe("matrix-mul FAILED at", row+i, j, host[i*n+j], "!=", want);
+					return false;
+				}
+			}
+	}
+	return true;
+}
+
+int main(int argc, char * argv[])
+{
+	bool cpu = false, peers = false;
+	std::vector<char *> args;
+	for (int i=0; i<argc; i++)
+	{
+		const std::string_view arg{argv[i]};
+		if (arg == "--cpu")
+			cpu = true;
+		else if (arg == "--devices")
+			peers = true;
+		else
+			args.push_back(argv[i]);
+	}
+	const auto opts = samples::bench::parse_options(static_cast<int>(args.size()), args.data());
+	sycl::queue queue = cpu ? sycl::queue{sycl::cpu_selector_v} : samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+
+	const auto devices = peers ? partition::peer_devices(queue.get_device()) : partition::numa_domains(queue.get_device());
+	utx::printe(peers ? "devices:" : "numa sub-devices:", devices.size());
+	for (const auto & device: devices)
+		utx::printe("\t", device.get_info<sycl::info::device::name>(),
+			"compute units:", device.get_info<sycl::info::device::max_compute_units>());
+
+	bool ok = true;
+	for (std::size_t count=1; count<=devices.size(); count++)
+	{
+		const std::vector<sycl::device> used(devices.begin(), devices.begin()+count);
+		ok = vector_add(used, opts, report) && ok;
+		ok = matrix_mul(used, opts, report) && ok;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::partition: one launch split over NUMA sub-devices or several devices.
+//
+//	auto devices = samples::partition::numa_domains(queue.get_device());
+//	samples::partition::group parts{devices};
+//	for (const auto & s: samples::partition::split(sycl::range<1>{size}, parts.size()))
+//		...
+//
+// numa_domains partitions a device with create_sub_devices(partition_by_affinity_domain,
+// numa), and falls back to the device itself when it cannot be partitioned that way.
+// peer_devices takes every device of the same type on the platform instead. A group
+// holds one queue and one usm_pool per partition, all in one context.
+//
+// split cuts a 1d, 2d or 3d range into slabs along dimension 0, one per partition. Each
+// partition should own the memory of its slab, allocated from its pool and initialised
+// by first_touch: the writes then come from the partition's own threads, so on a cpu
+// device the pages land on the NUMA node that later reads them.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace samples::partition
+{
+
+// One sub-device per NUMA node of device, or device alone.
+inline std::vector<sycl::device> numa_domains(const sycl::device & device)
+{
+	const auto properties = device.get_info<sycl::info::device::partition_properties>();
+	const auto domains = device.get_info<sycl::info::device::partition_affinity_domains>();
+	const bool numa =
+		std::find(properties.begin(), properties.end(),
+			sycl::info::partition_property::partition_by_affinity_domain) != properties.end() &&
+		std::find(domains.begin(), domains.end(),
+			sycl::info::partition_affinity_domain::numa) != domains.end();
+	if (numa)
+	{
+		try
+		{
+			auto sub_devices = device.create_sub_devices<sycl::info::partition_property::partition_by_affinity_domain>(
+				sycl::info::partition_affinity_domain::numa);
+			if (! sub_devices.empty())
+				return sub_devices;
+		}
+		catch (const sycl::exception &)
+		{
+			// a single NUMA node is reported as feature_not_supported by some backends
+		}
+	}
+	return {device};
+}
+
+// Every device of the platform of device with the same device type.
+inline std::vector<sycl::device> peer_devices(const sycl::device & device)
+{
+	return device.get_platform().get_devices(device.get_info<sycl::info::device::device_type>());
+}
+
+template <int dims>
+struct slice
+{
+	sycl::range<dims> range;
+	sycl::id<dims> offset;
+};
+
+// Splits range along dimension 0 into at most parts slabs of nearly equal size. Every slab
+// but the last has a multiple of align rows, so a slab can be tiled on its own.
+template <int dims>
+std::vector<slice<dims>> split(const sycl::range<dims> & range, std::size_t parts, std::size_t align = 1)
+{
+	const std::size_t rows = range[0];
+	const std::size_t step = round_up((rows + std::max<std::size_t>(parts, 1) - 1)/std::max<std::size_t>(parts, 1),
+		std::max<std::size_t>(align, 1));
+	std::vector<slice<dims>> slices;
+	for (std::size_t begin=0; begin<rows; begin+=step)
+	{
+		slice<dims> s{range, sycl::id<dims>{}};
+		s.range[0] = std::min(step, rows-begin);
+		s.offset[0] = begin;
+		slices.push_back(s);
+	}
+	return slices;
+}
+
+// One queue and one device usm_pool per partition.
+class group
+{
+private:
+	std::vector<sycl::device> devices;
+	sycl::context context;
+	std::vector<sycl::queue> queues;
+	std::vector<std::unique_ptr<usm_pool>> pools;
+
+public:
+	explicit group(std::vector<sycl::device> partitions, const sycl::property_list & props = {}):
+		devices{std::move(partitions)},
+		context{devices}
+	{
+		if (devices.empty())
+			throw std::invalid_argument{"samples::partition::group: no devices"};
+		for (const auto & device: devices)
+		{
+			queues.emplace_back(context, device, props);
+			pools.push_back(std::make_unique<usm_pool>(queues.back(), sycl::usm::alloc::device));
+		}
+	}
+
+	group(const group &) = delete;
+	group & operator=(const group &) = delete;
+
+	std::size_t size() const
+	{
+		return queues.size();
+	}
+
+	sycl::queue & queue(std::size_t part)
+	{
+		return queues[part];
+	}
+
+	usm_pool & pool(std::size_t part)
+	{
+		return *pools[part];
+	}
+
+	void wait()
+	{
+		for (auto & q: queues)
+			q.wait();
+	}
+};
+
+template <typename data_type, typename init_type>
+class first_touch_kernel
+{
+private:
+	data_type * ptr;
+	std::size_t offset;
+	init_type init;
+public:
+	first_touch_kernel(data_type * ptr, std::size_t offset, init_type init):
+		ptr{ptr},
+		offset{offset},
+		init{init}
+	{
+	}
+	void operator()(sycl::id<1> id) const
+	{
+		ptr[id[0]] = init(offset + id[0]);
+	}
+};
+
+// ptr[i] = init(offset+i) for i in [0, size), written by the threads of queue's device.
+template <typename data_type, typename init_type>
+sycl::event first_touch(sycl::queue & queue, data_type * ptr, std::size_t size, std::size_t offset, init_type init)
+{
+	return queue.parallel_for(sycl::range<1>{size}, first_touch_kernel<data_type, init_type>{ptr, offset, init});
+}
+
+} // namespace samples::partition
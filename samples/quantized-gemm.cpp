@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// fc32, ic32, half and int8/uint8 quantized matrix products (see quantized-gemm.hpp).
+//
+//	quantized-gemm --gemm-size=1024 --warmup=2 --repeat=10 --format=csv
+//
+// A and B are uniform in [-1, 1]. Every fp32 output is compared with a double precision
+// host product: the max abs error and the rms error relative to the rms of C go to stderr.
+// ic32 multiplies small integers and is there for throughput only.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "gemm.hpp"
+#include "quantized-gemm.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename data_type>
+samples::pooled_ptr<data_type> to_device(sycl::queue & queue, samples::usm_pool & pool, const std::vector<data_type> & host)
+{
+	auto ptr = samples::make_pooled<data_type>(pool, host.size());
+	queue.memcpy(ptr.get(), host.data(), host.size()*sizeof(data_type)).wait();
+	return ptr;
+}
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t m = opts.gemm_size, n = opts.gemm_size, k = opts.gemm_size;
+	const double flops = 2.0*m*n*k;
+	auto traffic = [&] (std::size_t in_bytes)
+	{
+		return static_cast<double>((m*k + k*n)*in_bytes + m*n*sizeof(float));
+	};
+
+	std::mt19937 gen{2023};
+	std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+	std::vector<float> a(m*k), b(k*n);
+	for (auto & x: a)
+		x = dist(gen);
+	for (auto & x: b)
+		x = dist(gen);
+
+	std::vector<double> ref(m*n, 0.0);
+	for (std::size_t i=0; i<m; i++)
+		for (std::size_t p=0; p<k; p++)
+			for (std::size_t j=0; j<n; j++)
+				ref[i*n+j] += static_cast<double>(a[i*k+p]) * b[p*n+j];
+	double ref_rms = 0;
+	for (double x: ref)
+		ref_rms += x*x;
+	ref_rms = std::sqrt(ref_rms/ref.size());
+
+	auto c = samples::make_pooled<utx::fc32>(pool, m*n);
+	std::vector<utx::fc32> result(m*n);
+	auto accuracy = [&] (const std::string & name)
+	{
+		queue.memcpy(result.data(), c.get(), m*n*sizeof(utx::fc32)).wait();
+		double max_error = 0, rms = 0;
+		for (std::size_t i=0; i<m*n; i++)
+		{
+			const double error = std::abs(result[i]() - ref[i]);
+			max_error = std::max(max_error, error);
+			rms += error*error;
+		}
+		rms = std::sqrt(rms/(m*n))/ref_rms;
+		utx::printe(name, "max error:", max_error, "relative rms error:", rms);
+		return rms;
+	};
+	bool ok = true;
+
+	// fc32
+	{
+		std::vector<utx::fc32> host_a(a.begin(), a.end()), host_b(b.begin(), b.end());
+		auto da = to_device(queue, pool, host_a), db = to_device(queue, pool, host_b);
+		report(samples::bench::run(opts, "gemm-fc32", "fc32", m, traffic(4), flops,
+			[&] { return samples::gemm(queue, da.get(), db.get(), c.get(), m, n, k); }));
+		ok = accuracy("gemm-fc32") < 1e-5 && ok;
+	}
+
+	// ic32, small integers
+	{
+		std::vector<utx::ic32> host_a(m*k), host_b(k*n);
+		for (std::size_t i=0; i<m*k; i++)
+			host_a[i] = static_cast<int>(i%9) - 4;
+		for (std::size_t i=0; i<k*n; i++)
+			host_b[i] = static_cast<int>(i%7) - 3;
+		auto da = to_device(queue, pool, host_a), db = to_device(queue, pool, host_b);
+		auto dc = samples::make_pooled<utx::ic32>(pool, m*n);
+		report(samples::bench::run(opts, "gemm-ic32", "ic32", m, traffic(4), flops,
+			[&] { return samples::gemm(queue, da.get(), db.get(), dc.get(), m, n, k); }));
+	}
+
+	// half inputs, fp32 accumulation
+	if (queue.get_device().has(sycl::aspect::fp16))
+	{
+		std::vector<sycl::half> host_a(a.begin(), a.end()), host_b(b.begin(), b.end());
+		auto da = to_device(queue, pool, host_a), db = to_device(queue, pool, host_b);
+		report(samples::bench::run(opts, "gemm-half", "half", m, traffic(2), flops,
+			[&] { return samples::gemm_half(queue, da.get(), db.get(), c.get(), m, n, k); }));
+		ok = accuracy("gemm-half") < 1e-2 && ok;
+	}
+	else
+		utx::printe("gemm-half: skipped, the device has no fp16");
+
+	// int8 and uint8 inputs, int32 accumulation
+	auto quantized = [&] <typename int8_type> (const std::string & name)
+	{
+		const auto qa = samples::quantize_rows<int8_type>(a.data(), m, k);
+		const auto qb = samples::quantize_columns<int8_type>(b.data(), k, n);
+		auto da = to_device(queue, pool, qa.data), db = to_device(queue, pool, qb.data);
+		auto sa = to_device(queue, pool, qa.scale), sb = to_device(queue, pool, qb.scale);
+		auto za = to_device(queue, pool, qa.zero_point), zb = to_device(queue, pool, qb.zero_point);
+		const samples::quantized_matrix<int8_type> ma{da.get(), sa.get(), za.get()}, mb{db.get(), sb.get(), zb.get()};
+		report(samples::bench::run(opts, name, name.substr(5), m, traffic(1), flops,
+			[&] { return samples::gemm_quantized(queue, ma, mb, c.get(), m, n, k); }));
+		return accuracy(name) < 5e-2;
+	};
+	ok = quantized.template operator()<std::int8_t>("gemm-int8") && ok;
+	ok = quantized.template operator()<std::uint8_t>("gemm-uint8") && ok;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Low precision matrix products on the tiled gemm kernel (gemm.hpp), usm row-major.
+//
+//	samples::gemm_half       sycl::half A and B, fp32 accumulation and fp32 C.
+//	samples::gemm_quantized  int8 or uint8 A and B, int32 accumulation, fp32 C:
+//	                             C[i][j] = scale_a[i]*scale_b[j] * sum_p (A[i][p]-zero_a[i]) * (B[p][j]-zero_b[j])
+//	                         A is quantized per row, B per column.
+//
+// samples::quantize_rows and samples::quantize_columns compute the scales and zero
+// points on the host: symmetric (zero point 0) for int8, asymmetric for uint8.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "gemm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace samples
+{
+
+// int8/uint8 matrix with a scale and a zero point per row (A) or per column (B)
+template <typename int8_type>
+struct quantized_matrix
+{
+	const int8_type * data;
+	const float * scale;
+	const std::int32_t * zero_point;
+};
+
+template <typename int8_type>
+struct quantized_host
+{
+	std::vector<int8_type> data;
+	std::vector<float> scale;
+	std::vector<std::int32_t> zero_point;
+};
+
+template <typename tile_type>
+class gemm_half_kernel;
+
+template <typename int8_type, typename tile_type>
+class gemm_quantized_kernel;
+
+// c = a x b; a is m x k, b is k x n, c is m x n.
+template <typename tile_type=gemm_tile<>>
+sycl::event gemm_half(
+	sycl::queue & queue,
+	const sycl::half * a,
+	const sycl::half * b,
+	utx::fc32 * c,
+	std::size_t m, std::size_t n, std::size_t k,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	check_gemm_tile<tile_type, sycl::half>(queue.get_device());
+	float * out = raw_pointer(c);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			gemm_tiled_core<gemm_half_kernel<tile_type>, sycl::half, float, tile_type>(
+				handler,
+				[=] (std::size_t row, std::size_t q)
+				{
+					return a[row*k+q];
+				},
+				[=] (std::size_t q, std::size_t col)
+				{
+					return b[q*n+col];
+				},
+				[=] (std::size_t row, std::size_t col, float sum)
+				{
+					out[row*n+col] = sum;
+				},
+				m, n, k
+			);
+		}
+	);
+}
+
+// c = dequantized a x b; a is m x k quantized per row, b is k x n quantized per column.
+// The zero points are subtracted while the tiles are loaded, so local memory holds int16.
+template <typename int8_type, typename tile_type=gemm_tile<>>
+sycl::event gemm_quantized(
+	sycl::queue & queue,
+	quantized_matrix<int8_type> a,
+	quantized_matrix<int8_type> b,
+	utx::fc32 * c,
+	std::size_t m, std::size_t n, std::size_t k,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	static_assert(std::is_same_v<int8_type, std::int8_t> || std::is_same_v<int8_type, std::uint8_t>);
+	check_gemm_tile<tile_type, std::int16_t>(queue.get_device());
+	float * out = raw_pointer(c);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			gemm_tiled_core<gemm_quantized_kernel<int8_type, tile_type>, std::int16_t, std::int32_t, tile_type>(
+				handler,
+				[=] (std::size_t row, std::size_t q)
+				{
+					return static_cast<std::int16_t>(a.data[row*k+q] - a.zero_point[row]);
+				},
+				[=] (std::size_t q, std::size_t col)
+				{
+					return static_cast<std::int16_t>(b.data[q*n+col] - b.zero_point[col]);
+				},
+				[=] (std::size_t row, std::size_t col, std::int32_t sum)
+				{
+					out[row*n+col] = a.scale[row]*b.scale[col]*static_cast<float>(sum);
+				},
+				m, n, k
+			);
+		}
+	);
+}
+
+// Quantizes the values of count vectors of length len; element e of vector v is at
+// values[v*v_stride + e*e_stride].
+template <typename int8_type>
+quantized_host<int8_type> quantize(
+	const float * values, std::size_t count, std::size_t len,
+	std::size_t v_stride, std::size_t e_stride, std::size_t size
+)
+{
+	constexpr float qmin = std::numeric_limits<int8_type>::min();
+	constexpr float qmax = std::numeric_limits<int8_type>::max();
+	quantized_host<int8_type> q{std::vector<int8_type>(size), std::vector<float>(count), std::vector<std::int32_t>(count)};
+	for (std::size_t v=0; v<count; v++)
+	{
+		float lo = 0, hi = 0;
+		for (std::size_t e=0; e<len; e++)
+		{
+			lo = std::min(lo, values[v*v_stride + e*e_stride]);
+			hi = std::max(hi, values[v*v_stride + e*e_stride]);
+		}
+		float scale;
+		std::int32_t zero;
+		if constexpr (std::is_signed_v<int8_type>)
+		{
+			scale = std::max(-lo, hi)/qmax;
+			zero = 0;
+		}
+		else
+		{
+			scale = (hi-lo)/(qmax-qmin);
+			zero = scale > 0 ? static_cast<std::int32_t>(std::lround(qmin - lo/scale)) : 0;
+		}
+		if (scale == 0)
+			scale = 1;
+		q.scale[v] = scale;
+		q.zero_point[v] = zero;
+		for (std::size_t e=0; e<len; e++)
+		{
+			const float x = std::round(values[v*v_stride + e*e_stride]/scale) + zero;
+			q.data[v*v_stride + e*e_stride] = static_cast<int8_type>(std::clamp(x, qmin, qmax));
+		}
+	}
+	return q;
+}
+
+// m x k row-major matrix, one scale and zero point per row
+template <typename int8_type>
+quantized_host<int8_type> quantize_rows(const float * values, std::size_t rows, std::size_t cols)
+{
+	return quantize<int8_type>(values, rows, cols, cols, 1, rows*cols);
+}
+
+// k x n row-major matrix, one scale and zero point per column
+template <typename int8_type>
+quantized_host<int8_type> quantize_columns(const float * values, std::size_t rows, std::size_t cols)
+{
+	return quantize<int8_type>(values, cols, rows, 1, cols, rows*cols);
+}
+
+} // namespace samples
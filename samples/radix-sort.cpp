@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Device radix sorts (see radix-sort.hpp) against std::sort and std::stable_sort with
+// std::execution::par.
+//
+//	radix-sort --size=100000000 --warmup=2 --repeat=10 --format=csv
+//
+// Random ic32, uc32 and fc32 keys over their whole range (fc32 in [-1e6, 1e6)), sorted
+// with 8 and 4 bit digits, and sorted by key with their input index as the payload. All
+// runs are timed on the host up to the end of the sort, so the device and the std runs
+// compare as they are; every std run copies the unsorted keys first, every device run
+// sorts from the unsorted keys into a second array.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "radix-sort.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename data_type>
+bool bench_type(
+	sycl::queue & queue,
+	samples::usm_pool & pool,
+	const samples::bench::options & opts,
+	samples::bench::reporter & report,
+	const std::string & type
+)
+{
+	using raw_type = samples::raw_value_t<data_type>;
+	const std::size_t size = opts.size;
+	const std::size_t bytes = size*sizeof(data_type);
+
+	std::mt19937 gen{7};
+	std::vector<data_type> host(size);
+	std::vector<raw_type> raw(size);
+	for (std::size_t i=0; i<size; i++)
+	{
+		if constexpr (std::is_floating_point_v<raw_type>)
+			raw[i] = std::uniform_real_distribution<raw_type>{-1e6, 1e6}(gen);
+		else
+			raw[i] = std::uniform_int_distribution<raw_type>{std::numeric_limits<raw_type>::min(),
+				std::numeric_limits<raw_type>::max()}(gen);
+		host[i] = data_type(raw[i]);
+	}
+
+	auto in = samples::make_pooled<data_type>(pool, size);
+	auto out = samples::make_pooled<data_type>(pool, size);
+	auto index = samples::make_pooled<std::uint32_t>(pool, size);
+	auto sorted_index = samples::make_pooled<std::uint32_t>(pool, size);
+	std::vector<std::uint32_t> host_index(size);
+	for (std::size_t i=0; i<size; i++)
+		host_index[i] = static_cast<std::uint32_t>(i);
+	queue.memcpy(in.get(), host.data(), bytes).wait();
+	queue.memcpy(index.get(), host_index.data(), size*sizeof(std::uint32_t)).wait();
+
+	bool ok = true;
+	std::vector<data_type> got(size);
+	std::vector<std::uint32_t> got_index(size);
+	std::vector<raw_type> want(size);
+	std::vector<std::pair<raw_type, std::uint32_t>> want_pairs(size);
+
+	auto check_keys = [&] (const std::string & name)
+	{
+		queue.memcpy(got.data(), out.get(), bytes).wait();
+		for (std::size_t i=0; i<size; i++)
+			if (got[i]() != want[i])
+			{
+				utx::printe(name, type, "FAILED at", i, got[i], "!=", want[i]);
+				return false;
+			}
+		return true;
+	};
+
+	report(samples::bench::run_host(opts, "std::sort-par", type, size, 2.0*bytes, 0,
+		[&]
+		{
+			std::copy(raw.begin(), raw.end(), want.begin());
+			std::sort(std::execution::par, want.begin(), want.end());
+		}
+	));
+
+	report(samples::bench::run_host(opts, "radix_sort-8", type, size, 2.0*bytes, 0,
+		[&]
+		{
+			samples::radix_sort<8>(queue, pool, in.get(), out.get(), size).wait();
+		}
+	));
+	ok = check_keys("radix_sort-8") && ok;
+
+	report(samples::bench::run_host(opts, "radix_sort-4", type, size, 2.0*bytes, 0,
+		[&]
+		{
+			samples::radix_sort<4>(queue, pool, in.get(), out.get(), size).wait();
+		}
+	));
+	ok = check_keys("radix_sort-4") && ok;
+
+	// key-value: stable, so equal keys keep their index order
+	report(samples::bench::run_host(opts, "std::stable_sort-par-by-key", type, size, 4.0*bytes, 0,
+		[&]
+		{
+			for (std::size_t i=0; i<size; i++)
+				want_pairs[i] = {raw[i], static_cast<std::uint32_t>(i)};
+			std::stable_sort(std::execution::par, want_pairs.begin(), want_pairs.end(),
+				[] (const auto & a, const auto & b) { return a.first < b.first; });
+		}
+	));
+	report(samples::bench::run_host(opts, "radix_sort_by_key-8", type, size, 4.0*bytes, 0,
+		[&]
+		{
+			samples::radix_sort_by_key<8>(queue, pool, in.get(), index.get(), out.get(), sorted_index.get(), size).wait();
+		}
+	));
+	ok = check_keys("radix_sort_by_key-8") && ok;
+	queue.memcpy(got_index.data(), sorted_index.get(), size*sizeof(std::uint32_t)).wait();
+	for (std::size_t i=0; i<size; i++)
+		if (got_index[i] != want_pairs[i].second)
+		{
+			utx::printe("radix_sort_by_key-8", type, "FAILED at", i, got_index[i], "!=", want_pairs[i].second);
+			ok = false;
+			break;
+		}
+	return ok;
+}
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	bool ok = bench_type<utx::ic32>(queue, pool, opts, report, "ic32");
+	ok = bench_type<utx::uc32>(queue, pool, opts, report, "uc32") && ok;
+	ok = bench_type<utx::fc32>(queue, pool, opts, report, "fc32") && ok;
+	queue.wait();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,321 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Device LSD radix sort of 32 bit keys, with an optional payload, on usm memory.
+//
+//	samples::radix_sort(queue, pool, keys, size);                                  // in place
+//	samples::radix_sort<4>(queue, pool, keys_in, keys_out, size);                  // 4 bit digits
+//	samples::radix_sort_by_key(queue, pool, keys_in, values_in, keys_out, values_out, size);
+//
+// Keys are utx::uc32, utx::ic32, utx::fc32 or their raw types. They are first mapped to
+// unsigned integers of the same order (the sign bit flipped for signed integers, all bits
+// flipped for negative floats), sorted with ceil(32/radix_bits) passes of radix_bits each,
+// lowest digit first, and mapped back. Every pass is three kernels:
+//	histogram   every work-group counts the digits of its block in local memory bins,
+//	            counts[digit*blocks + block]
+//	scan        samples::exclusive_scan of counts, the first output position of every
+//	            digit in every block
+//	scatter     every work-group takes its block in rounds of one key per work-item,
+//	            sorts a round by digit with radix_bits stable one bit splits in local
+//	            memory (exclusive_scan_over_group of the bit), and writes every key to
+//	            its block offset plus its rank among the equal digits before it.
+// Every pass is stable, so the sort is stable: values with equal keys keep their order.
+// -0.0f sorts before 0.0f, NaNs after the infinity of their sign. radix_bits goes from 1 to 8;
+// fewer bits mean more passes with fewer local memory bins and splits each. size must be
+// below 2^32. Scratch memory, two copies of the keys (and values) and the counts, comes
+// from a samples::usm_pool and goes back to it when the last kernel has finished.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "group-algorithms.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace samples
+{
+
+template <typename raw_type, typename value_type, unsigned radix_bits, int stage>
+class radix_sort_kernel;
+
+// unsigned integer with the order of key
+template <typename raw_type>
+std::uint32_t radix_encode(raw_type key)
+{
+	if constexpr (std::is_floating_point_v<raw_type>)
+	{
+		const std::uint32_t bits = sycl::bit_cast<std::uint32_t>(key);
+		return bits ^ (bits >> 31 ? 0xFFFFFFFFu : 0x80000000u);
+	}
+	else if constexpr (std::is_signed_v<raw_type>)
+		return static_cast<std::uint32_t>(key) ^ 0x80000000u;
+	else
+		return key;
+}
+
+template <typename raw_type>
+raw_type radix_decode(std::uint32_t bits)
+{
+	if constexpr (std::is_floating_point_v<raw_type>)
+		return sycl::bit_cast<raw_type>(bits ^ (bits >> 31 ? 0x80000000u : 0xFFFFFFFFu));
+	else if constexpr (std::is_signed_v<raw_type>)
+		return static_cast<raw_type>(bits ^ 0x80000000u);
+	else
+		return bits;
+}
+
+// value_type void sorts keys only
+template <unsigned radix_bits, typename key_type, typename value_type>
+sycl::event radix_sort_impl(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const key_type * keys_in, const value_type * values_in,
+	key_type * keys_out, value_type * values_out,
+	std::size_t size,
+	const std::vector<sycl::event> & deps
+)
+{
+	using raw_type = raw_value_t<key_type>;
+	static_assert(sizeof(raw_type) == 4 && (std::is_floating_point_v<raw_type> || std::is_integral_v<raw_type>),
+		"samples::radix_sort takes 32 bit integer and floating point keys");
+	static_assert(radix_bits >= 1 && radix_bits <= 8, "samples::radix_sort takes 1 to 8 bit digits");
+	constexpr bool has_values = ! std::is_void_v<value_type>;
+	using payload_type = std::conditional_t<has_values, value_type, unsigned char>;
+	constexpr std::uint32_t digits = 1u << radix_bits;
+	constexpr std::uint32_t mask = digits-1;
+	constexpr unsigned passes = (32+radix_bits-1)/radix_bits;
+	constexpr std::size_t per_item = 16;
+
+	if (size == 0)
+		return queue.memcpy(keys_out, keys_in, 0, deps);
+
+	const std::size_t wg = algorithm_work_group(queue);
+	const std::size_t block = wg*per_item;
+	const std::size_t blocks = (size+block-1)/block;
+	std::uint32_t * keys[2] = {pool.allocate<std::uint32_t>(size), pool.allocate<std::uint32_t>(size)};
+	payload_type * values[2] = {};
+	if constexpr (has_values)
+	{
+		values[0] = pool.allocate<payload_type>(size);
+		values[1] = pool.allocate<payload_type>(size);
+	}
+	std::uint32_t * counts = pool.allocate<std::uint32_t>(digits*blocks);
+	std::uint32_t * offsets = pool.allocate<std::uint32_t>(digits*blocks);
+	const raw_type * src = raw_pointer(keys_in);
+	raw_type * dst = raw_pointer(keys_out);
+
+	sycl::event done = queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			std::uint32_t * encoded = keys[0];
+			handler.parallel_for<radix_sort_kernel<raw_type, value_type, radix_bits, 0>>(
+				sycl::range<1>{size},
+				[=] (sycl::id<1> id)
+				{
+					encoded[id] = radix_encode(src[id]);
+				}
+			);
+		}
+	);
+
+	for (unsigned pass=0; pass<passes; pass++)
+	{
+		const unsigned shift = pass*radix_bits;
+		const std::uint32_t * key_src = keys[pass%2];
+		std::uint32_t * key_dst = keys[(pass+1)%2];
+		const payload_type * value_src = nullptr;
+		payload_type * value_dst = nullptr;
+		if constexpr (has_values)
+		{
+			value_src = pass == 0 ? values_in : values[(pass+1)%2];
+			value_dst = pass+1 == passes ? values_out : values[pass%2];
+		}
+
+		// 1. digit counts of every block
+		sycl::event counted = queue.submit(
+			[&] (sycl::handler & handler)
+			{
+				handler.depends_on(done);
+				auto bins = sycl::local_accessor<std::uint32_t, 1>{sycl::range<1>{digits}, handler};
+				handler.parallel_for<radix_sort_kernel<raw_type, value_type, radix_bits, 1>>(
+					sycl::nd_range<1>{blocks*wg, wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const std::size_t lid = item.get_local_id(0);
+						const std::size_t g = item.get_group(0);
+						for (std::size_t d=lid; d<digits; d+=wg)
+							bins[d] = 0;
+						sycl::group_barrier(item.get_group());
+						const std::size_t last = std::min(size, (g+1)*block);
+						for (std::size_t i=g*block+lid; i<last; i+=wg)
+							sycl::atomic_ref<std::uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::work_group,
+								sycl::access::address_space::local_space>{bins[key_src[i] >> shift & mask]}.fetch_add(1);
+						sycl::group_barrier(item.get_group());
+						for (std::size_t d=lid; d<digits; d+=wg)
+							counts[d*blocks + g] = bins[d];
+					}
+				);
+			}
+		);
+
+		// 2. first output position of every digit in every block
+		sycl::event scanned = samples::exclusive_scan(queue, pool, counts, digits*blocks, offsets, sycl::plus<>{}, {counted});
+
+		// 3. stable scatter, one round of wg keys at a time
+		done = queue.submit(
+			[&] (sycl::handler & handler)
+			{
+				handler.depends_on(scanned);
+				auto local_keys = sycl::local_accessor<std::uint32_t, 1>{sycl::range<1>{wg}, handler};
+				auto local_values = sycl::local_accessor<payload_type, 1>{sycl::range<1>{has_values ? wg : 1}, handler};
+				auto first = sycl::local_accessor<std::uint32_t, 1>{sycl::range<1>{digits}, handler};
+				auto base = sycl::local_accessor<std::uint32_t, 1>{sycl::range<1>{digits}, handler};
+				handler.parallel_for<radix_sort_kernel<raw_type, value_type, radix_bits, 2>>(
+					sycl::nd_range<1>{blocks*wg, wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const auto group = item.get_group();
+						const std::size_t lid = item.get_local_id(0);
+						const std::size_t g = item.get_group(0);
+						auto digit = [=] (std::uint32_t key) { return key >> shift & mask; };
+						for (std::size_t d=lid; d<digits; d+=wg)
+							base[d] = offsets[d*blocks + g];
+						sycl::group_barrier(group);
+
+						for (std::size_t round=0; round<per_item; round++)
+						{
+							const std::size_t start = g*block + round*wg;
+							if (start >= size)
+								break;
+							const std::size_t count = std::min(wg, size-start);
+							// the work-items past the end hold the largest digit and stay behind the keys
+							std::uint32_t key = lid < count ? key_src[start+lid] : 0xFFFFFFFFu;
+							payload_type value{};
+							if constexpr (has_values)
+								if (lid < count)
+									value = value_src[start+lid];
+
+							// split on every digit bit, lowest first: zeros before ones, in order
+							for (unsigned b=0; b<radix_bits; b++)
+							{
+								const std::uint32_t flag = digit(key) >> b & 1;
+								const std::uint32_t ones_before = sycl::exclusive_scan_over_group(group, flag, sycl::plus<>{});
+								const std::uint32_t ones = sycl::reduce_over_group(group, flag, sycl::plus<>{});
+								const std::size_t to = flag ? wg-ones+ones_before : lid-ones_before;
+								local_keys[to] = key;
+								if constexpr (has_values)
+									local_values[to] = value;
+								sycl::group_barrier(group);
+								key = local_keys[lid];
+								if constexpr (has_values)
+									value = local_values[lid];
+								sycl::group_barrier(group);
+							}
+
+							// rank among the equal digits of the round: lid - first[d]
+							const std::uint32_t d = digit(key);
+							if (lid == 0 || digit(local_keys[lid-1]) != d)
+								first[d] = lid;
+							sycl::group_barrier(group);
+							if (lid < count)
+							{
+								key_dst[base[d] + lid - first[d]] = key;
+								if constexpr (has_values)
+									value_dst[base[d] + lid - first[d]] = value;
+							}
+							sycl::group_barrier(group);
+							if (lid+1 == wg || digit(local_keys[lid+1]) != d)
+								base[d] += lid - first[d] + 1;
+							sycl::group_barrier(group);
+						}
+					}
+				);
+			}
+		);
+	}
+
+	done = queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(done);
+			const std::uint32_t * sorted = keys[passes%2];
+			handler.parallel_for<radix_sort_kernel<raw_type, value_type, radix_bits, 3>>(
+				sycl::range<1>{size},
+				[=] (sycl::id<1> id)
+				{
+					dst[id] = radix_decode<raw_type>(sorted[id]);
+				}
+			);
+		}
+	);
+	release_after(queue, pool, keys[0], done);
+	release_after(queue, pool, keys[1], done);
+	if constexpr (has_values)
+	{
+		release_after(queue, pool, values[0], done);
+		release_after(queue, pool, values[1], done);
+	}
+	release_after(queue, pool, counts, done);
+	release_after(queue, pool, offsets, done);
+	return done;
+}
+
+// keys_out[0, size) = keys_in[0, size) in ascending order; keys_out may be keys_in
+template <unsigned radix_bits = 8, typename key_type>
+sycl::event radix_sort(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const key_type * keys_in, key_type * keys_out, std::size_t size,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return radix_sort_impl<radix_bits, key_type, void>(queue, pool, keys_in, nullptr, keys_out, nullptr, size, deps);
+}
+
+template <unsigned radix_bits = 8, typename key_type>
+sycl::event radix_sort(
+	sycl::queue & queue,
+	usm_pool & pool,
+	key_type * keys, std::size_t size,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return radix_sort<radix_bits>(queue, pool, keys, keys, size, deps);
+}
+
+// sorts the keys and moves every value with its key; equal keys keep their order
+template <unsigned radix_bits = 8, typename key_type, typename value_type>
+sycl::event radix_sort_by_key(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const key_type * keys_in, const value_type * values_in,
+	key_type * keys_out, value_type * values_out,
+	std::size_t size,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return radix_sort_impl<radix_bits>(queue, pool, keys_in, values_in, keys_out, values_out, size, deps);
+}
+
+template <unsigned radix_bits = 8, typename key_type, typename value_type>
+sycl::event radix_sort_by_key(
+	sycl::queue & queue,
+	usm_pool & pool,
+	key_type * keys, value_type * values, std::size_t size,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return radix_sort_by_key<radix_bits>(queue, pool, keys, values, keys, values, size, deps);
+}
+
+} // namespace samples
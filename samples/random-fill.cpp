@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Device-side iota, constant, uniform and normal fills (see random.hpp) against filling
+// host memory and copying it to the device.
+//
+//	random-fill --size=67108864 --warmup=2 --repeat=10 --format=csv
+//
+// Every device fill is checked against samples::random::generate on the host; the mean and
+// the variance of the normal fill go to stderr.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/algorithm.hpp>
+#include "bench.hpp"
+#include "random.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rng = samples::random;
+
+constexpr std::uint64_t seed = 20230915;
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t size = opts.size + 3; // a partial last block
+	auto data = samples::make_pooled<utx::fc32>(pool, size);
+	std::vector<utx::fc32> host(size), want(size);
+	const double bytes = size*sizeof(utx::fc32);
+
+	auto check = [&] (const std::string & name, double tolerance)
+	{
+		queue.memcpy(host.data(), data.get(), bytes).wait();
+		for (std::size_t i=0; i<size; i++)
+			if (std::abs(host[i]() - want[i]()) > tolerance*(1+std::abs(want[i]())))
+			{
+				utx::printe(name, "FAILED at", i, host[i], "!=", want[i]);
+				return false;
+			}
+		return true;
+	};
+	bool ok = true;
+
+	// the host fill + copy that the samples do today
+	report(samples::bench::run_host(opts, "host-iota-copy", "fc32", size, 2*bytes, 0,
+		[&]
+		{
+			utx::iota(host, 1);
+			queue.memcpy(data.get(), host.data(), bytes).wait();
+		}
+	));
+	const rng::uniform_generator<utx::fc32> uniform{rng::make_key(seed), 0, -1.0f, 1.0f};
+	report(samples::bench::run_host(opts, "host-uniform-copy", "fc32", size, 2*bytes, 0,
+		[&]
+		{
+			rng::generate(host.data(), size, uniform);
+			queue.memcpy(data.get(), host.data(), bytes).wait();
+		}
+	));
+
+	report(samples::bench::run(opts, "device-iota", "fc32", size, bytes, 0,
+		[&] { return rng::iota(queue, data.get(), size, 1.0f); }));
+	rng::generate(want.data(), size, rng::iota_generator<utx::fc32>{1.0f, 1.0f});
+	ok = check("device-iota", 0) && ok;
+
+	report(samples::bench::run(opts, "device-constant", "fc32", size, bytes, 0,
+		[&] { return rng::constant(queue, data.get(), size, 0.5f); }));
+	rng::generate(want.data(), size, rng::constant_generator<utx::fc32>{0.5f});
+	ok = check("device-constant", 0) && ok;
+
+	report(samples::bench::run(opts, "device-uniform", "fc32", size, bytes, 0,
+		[&] { return rng::fill(queue, data.get(), size, uniform); }));
+	rng::generate(want.data(), size, uniform);
+	ok = check("device-uniform", 1e-6) && ok;
+
+	// the same sequence written through a buffer
+	{
+		sycl::buffer<utx::fc32, 1> buffer{host.data(), sycl::range<1>{size}};
+		rng::fill(queue, buffer, uniform);
+	}
+	for (std::size_t i=0; i<size; i++)
+		if (std::abs(host[i]() - want[i]()) > 1e-6*(1+std::abs(want[i]())))
+		{
+			utx::printe("buffer-uniform FAILED at", i, host[i], "!=", want[i]);
+			ok = false;
+			break;
+		}
+
+	const rng::normal_generator<utx::fc32> normal{rng::make_key(seed), 1, 0.0f, 1.0f};
+	report(samples::bench::run(opts, "device-normal", "fc32", size, bytes, 0,
+		[&] { return rng::fill(queue, data.get(), size, normal); }));
+	rng::generate(want.data(), size, normal);
+	ok = check("device-normal", 1e-5) && ok;
+
+	double mean = 0, variance = 0;
+	for (const auto & x: host)
+		mean += x();
+	mean /= size;
+	for (const auto & x: host)
+		variance += (x()-mean)*(x()-mean);
+	variance /= size;
+	utx::printe("device-normal mean:", mean, "variance:", variance);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::random: device-side data generators on a Philox4x32-10 counter-based generator.
+//
+//	samples::random::uniform(queue, ptr, size, seed);              // [0, 1)
+//	samples::random::normal(queue, ptr, size, seed, 0.0f, 1.0f);
+//	samples::random::iota(queue, ptr, size, 1);
+//	samples::random::fill(queue, buffer, samples::random::constant_generator<utx::fc32>{2.0f});
+//
+// Element i is a pure function of (seed, stream, i): work-item b computes elements 4b..4b+3
+// from one philox call on the counter (b, stream), so results do not depend on the local
+// range, the device or the number of launches, and samples::random::generate fills host
+// memory with exactly the same values. Use a different stream for every independent
+// sequence drawn from one seed.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace samples::random
+{
+
+using counter_type = std::array<std::uint32_t, 4>;
+using key_type = std::array<std::uint32_t, 2>;
+
+// Philox4x32 with 10 rounds (Salmon et al., Parallel random numbers: as easy as 1, 2, 3).
+inline counter_type philox4x32(counter_type counter, key_type key)
+{
+	constexpr std::uint32_t m0 = 0xD2511F53, m1 = 0xCD9E8D57;
+	constexpr std::uint32_t w0 = 0x9E3779B9, w1 = 0xBB67AE85;
+	for (int round=0; round<10; round++)
+	{
+		const std::uint64_t p0 = std::uint64_t{m0}*counter[0];
+		const std::uint64_t p1 = std::uint64_t{m1}*counter[2];
+		counter = {
+			static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+			static_cast<std::uint32_t>(p1),
+			static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+			static_cast<std::uint32_t>(p0)
+		};
+		key[0] += w0;
+		key[1] += w1;
+	}
+	return counter;
+}
+
+inline key_type make_key(std::uint64_t seed)
+{
+	return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+}
+
+// the four random words of block b of a stream
+inline counter_type block_bits(std::uint64_t block, std::uint32_t stream, key_type key)
+{
+	return philox4x32({static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32), stream, 0}, key);
+}
+
+// 24 random bits to a float in [0, 1)
+inline float to_unit(std::uint32_t bits)
+{
+	return static_cast<float>(bits >> 8) * 0x1p-24f;
+}
+
+// A generator returns the 4 elements of block b: elements 4b, 4b+1, 4b+2 and 4b+3.
+
+template <typename data_type>
+struct iota_generator
+{
+	raw_value_t<data_type> start = 0, step = 1;
+
+	std::array<data_type, 4> operator()(std::uint64_t block) const
+	{
+		using raw_type = raw_value_t<data_type>;
+		std::array<data_type, 4> values;
+		for (std::size_t l=0; l<4; l++)
+			values[l] = data_type(static_cast<raw_type>(start + static_cast<raw_type>(block*4+l)*step));
+		return values;
+	}
+};
+
+template <typename data_type>
+struct constant_generator
+{
+	raw_value_t<data_type> value = 0;
+
+	std::array<data_type, 4> operator()(std::uint64_t) const
+	{
+		return {data_type(value), data_type(value), data_type(value), data_type(value)};
+	}
+};
+
+// uniform in [low, high)
+template <typename data_type>
+struct uniform_generator
+{
+	static_assert(std::is_floating_point_v<raw_value_t<data_type>>);
+	key_type key;
+	std::uint32_t stream = 0;
+	raw_value_t<data_type> low = 0, high = 1;
+
+	std::array<data_type, 4> operator()(std::uint64_t block) const
+	{
+		using raw_type = raw_value_t<data_type>;
+		const counter_type bits = block_bits(block, stream, key);
+		std::array<data_type, 4> values;
+		for (std::size_t l=0; l<4; l++)
+			values[l] = data_type(static_cast<raw_type>(low + (high-low)*static_cast<raw_type>(to_unit(bits[l]))));
+		return values;
+	}
+};
+
+// normal with mean and stddev, by Box-Muller on lanes (0, 1) and (2, 3)
+template <typename data_type>
+struct normal_generator
+{
+	static_assert(std::is_floating_point_v<raw_value_t<data_type>>);
+	key_type key;
+	std::uint32_t stream = 0;
+	raw_value_t<data_type> mean = 0, stddev = 1;
+
+	std::array<data_type, 4> operator()(std::uint64_t block) const
+	{
+		using raw_type = raw_value_t<data_type>;
+		constexpr float two_pi = 6.28318530717958647692f;
+		const counter_type bits = block_bits(block, stream, key);
+		std::array<data_type, 4> values;
+		for (std::size_t l=0; l<4; l+=2)
+		{
+			const float u1 = to_unit(bits[l]) + 0x1p-25f; // (0, 1), log(u1) stays finite
+			const float u2 = to_unit(bits[l+1]);
+			const float r = sycl::sqrt(-2.0f*sycl::log(u1));
+			values[l] = data_type(static_cast<raw_type>(mean + stddev*static_cast<raw_type>(r*sycl::cos(two_pi*u2))));
+			values[l+1] = data_type(static_cast<raw_type>(mean + stddev*static_cast<raw_type>(r*sycl::sin(two_pi*u2))));
+		}
+		return values;
+	}
+};
+
+// out[i] = element i of gen, for i in [0, size); out is a pointer or an accessor
+template <typename out_type, typename generator_type>
+class fill_kernel
+{
+private:
+	out_type out;
+	std::size_t size;
+	generator_type gen;
+public:
+	fill_kernel(out_type out, std::size_t size, generator_type gen):
+		out{out},
+		size{size},
+		gen{gen}
+	{
+	}
+	void operator()(sycl::id<1> id) const
+	{
+		const std::size_t first = id[0]*4;
+		const auto values = gen(id[0]);
+		for (std::size_t l=0; l<4 && first+l<size; l++)
+			out[first+l] = values[l];
+	}
+};
+
+template <typename data_type, typename generator_type>
+sycl::event fill(
+	sycl::queue & queue,
+	data_type * ptr, std::size_t size,
+	generator_type gen,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for(sycl::range<1>{(size+3)/4}, fill_kernel<data_type *, generator_type>{ptr, size, gen});
+		}
+	);
+}
+
+template <typename data_type, typename generator_type>
+sycl::event fill(
+	sycl::queue & queue,
+	sycl::buffer<data_type, 1> & buffer,
+	generator_type gen,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	const std::size_t size = buffer.size();
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			auto acc = sycl::accessor{buffer, handler, sycl::write_only, sycl::no_init};
+			handler.parallel_for(sycl::range<1>{(size+3)/4}, fill_kernel<decltype(acc), generator_type>{acc, size, gen});
+		}
+	);
+}
+
+// the same values on the host
+template <typename data_type, typename generator_type>
+void generate(data_type * out, std::size_t size, generator_type gen)
+{
+	for (std::size_t b=0; b*4<size; b++)
+	{
+		const auto values = gen(b);
+		for (std::size_t l=0; l<4 && b*4+l<size; l++)
+			out[b*4+l] = values[l];
+	}
+}
+
+template <typename data_type>
+sycl::event iota(
+	sycl::queue & queue,
+	data_type * ptr, std::size_t size,
+	raw_value_t<data_type> start, raw_value_t<data_type> step = 1,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return fill(queue, ptr, size, iota_generator<data_type>{start, step}, deps);
+}
+
+template <typename data_type>
+sycl::event constant(
+	sycl::queue & queue,
+	data_type * ptr, std::size_t size,
+	raw_value_t<data_type> value,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return fill(queue, ptr, size, constant_generator<data_type>{value}, deps);
+}
+
+template <typename data_type>
+sycl::event uniform(
+	sycl::queue & queue,
+	data_type * ptr, std::size_t size,
+	std::uint64_t seed,
+	raw_value_t<data_type> low = 0, raw_value_t<data_type> high = 1,
+	std::uint32_t stream = 0,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return fill(queue, ptr, size, uniform_generator<data_type>{make_key(seed), stream, low, high}, deps);
+}
+
+template <typename data_type>
+sycl::event normal(
+	sycl::queue & queue,
+	data_type * ptr, std::size_t size,
+	std::uint64_t seed,
+	raw_value_t<data_type> mean = 0, raw_value_t<data_type> stddev = 1,
+	std::uint32_t stream = 0,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return fill(queue, ptr, size, normal_generator<data_type>{make_key(seed), stream, mean, stddev}, deps);
+}
+
+} // namespace samples::random
@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Device reduce and scans (see group-algorithms.hpp) against std::reduce and
+// std::inclusive_scan / std::exclusive_scan with std::execution::par_unseq.
+//
+//	reduce-scan --size=16777216 --warmup=2 --repeat=10 --format=csv
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "group-algorithms.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+
+// floating point results are checked against a double precision reference, integer
+// results against a 64 bit one modulo 2^32, without overflow in the reference
+template <typename data_type>
+using reference_t = std::conditional_t<std::is_floating_point_v<samples::raw_value_t<data_type>>, double,
+	std::conditional_t<std::is_signed_v<samples::raw_value_t<data_type>>, std::int64_t, std::uint64_t>>;
+
+template <typename data_type>
+bool close_enough(data_type got, reference_t<data_type> want)
+{
+	using raw_type = samples::raw_value_t<data_type>;
+	const auto g = raw_type(got());
+	if constexpr (std::is_floating_point_v<raw_type>)
+		return std::abs(g-want) <= 1e-3*(1.0+std::abs(want));
+	else
+		return g == static_cast<raw_type>(want);
+}
+
+// + of the std baselines, modulo 2^32 for signed integers as well
+template <typename raw_type>
+struct wrapping_plus
+{
+	raw_type operator()(raw_type a, raw_type b) const
+	{
+		if constexpr (std::is_integral_v<raw_type>)
+			return static_cast<raw_type>(static_cast<std::make_unsigned_t<raw_type>>(a) + static_cast<std::make_unsigned_t<raw_type>>(b));
+		else
+			return a+b;
+	}
+};
+
+template <typename data_type>
+bool compare(const char * what, const std::string & type,
+	const std::vector<data_type> & got, const std::vector<reference_t<data_type>> & want)
+{
+	std::size_t errors = 0;
+	for (std::size_t i=0; i<want.size(); i++)
+		if (! close_enough(got[i], want[i]))
+			errors++;
+	if (errors)
+		utx::printe(what, type, "FAILED, errors:", errors);
+	return errors == 0;
+}
+
+template <typename data_type>
+bool bench_type(
+	sycl::queue & queue,
+	samples::usm_pool & pool,
+	const samples::bench::options & opts,
+	samples::bench::reporter & report,
+	const std::string & type
+)
+{
+	using raw_type = samples::raw_value_t<data_type>;
+	const std::size_t size = opts.size;
+	const std::size_t bytes = size*sizeof(data_type);
+
+	std::vector<data_type> host(size);
+	std::vector<raw_type> raw(size), raw_out(size);
+	for (std::size_t i=0; i<size; i++)
+	{
+		raw[i] = static_cast<raw_type>(i%7) / static_cast<raw_type>(std::is_floating_point_v<raw_type> ? 2 : 1);
+		host[i] = data_type(raw[i]);
+	}
+
+	auto in = samples::make_pooled<data_type>(pool, size);
+	auto out = samples::make_pooled<data_type>(pool, size);
+	auto sum = samples::make_pooled<data_type>(pool, 1);
+	queue.memcpy(in.get(), host.data(), bytes).wait();
+
+	// serial reference
+	using ref_type = reference_t<data_type>;
+	std::vector<ref_type> inclusive(size), exclusive(size);
+	ref_type total{};
+	for (std::size_t i=0; i<size; i++)
+	{
+		exclusive[i] = total;
+		total += raw[i];
+		inclusive[i] = total;
+	}
+
+	bool ok = true;
+	std::vector<data_type> got(size);
+
+	// reduce
+	raw_type host_sum{};
+	report(samples::bench::run(opts, "reduce", type, size, bytes, size,
+		[&]
+		{
+			return samples::reduce(queue, pool, in.get(), size, sum.get());
+		}
+	));
+	report(samples::bench::run_host(opts, "std::reduce-par_unseq", type, size, bytes, size,
+		[&]
+		{
+			host_sum = std::reduce(std::execution::par_unseq, raw.begin(), raw.end(), raw_type{}, wrapping_plus<raw_type>{});
+		}
+	));
+	data_type device_sum;
+	queue.memcpy(&device_sum, sum.get(), sizeof(data_type)).wait();
+	if (! close_enough(device_sum, total))
+	{
+		utx::printe("reduce", type, "FAILED:", device_sum, "!=", total, "std::reduce:", host_sum);
+		ok = false;
+	}
+
+	// inclusive scan
+	report(samples::bench::run(opts, "inclusive_scan", type, size, 2.0*bytes, size,
+		[&]
+		{
+			return samples::inclusive_scan(queue, pool, in.get(), size, out.get());
+		}
+	));
+	report(samples::bench::run_host(opts, "std::inclusive_scan-par_unseq", type, size, 2.0*bytes, size,
+		[&]
+		{
+			std::inclusive_scan(std::execution::par_unseq, raw.begin(), raw.end(), raw_out.begin(), wrapping_plus<raw_type>{});
+		}
+	));
+	queue.memcpy(got.data(), out.get(), bytes).wait();
+	ok = compare("inclusive_scan", type, got, inclusive) && ok;
+
+	// exclusive scan
+	report(samples::bench::run(opts, "exclusive_scan", type, size, 2.0*bytes, size,
+		[&]
+		{
+			return samples::exclusive_scan(queue, pool, in.get(), size, out.get());
+		}
+	));
+	report(samples::bench::run_host(opts, "std::exclusive_scan-par_unseq", type, size, 2.0*bytes, size,
+		[&]
+		{
+			std::exclusive_scan(std::execution::par_unseq, raw.begin(), raw.end(), raw_out.begin(), raw_type{},
+				wrapping_plus<raw_type>{});
+		}
+	));
+	queue.memcpy(got.data(), out.get(), bytes).wait();
+	ok = compare("exclusive_scan", type, got, exclusive) && ok;
+
+	// segments of random length between 0 and 4096
+	std::vector<std::size_t> offsets{0};
+	std::mt19937 gen{7};
+	std::uniform_int_distribution<std::size_t> length{0, 4096};
+	while (offsets.back() < size)
+		offsets.push_back(std::min(size, offsets.back()+length(gen)));
+	const std::size_t segments = offsets.size()-1;
+	auto dev_offsets = samples::make_pooled<std::size_t>(pool, offsets.size());
+	auto seg_sums = samples::make_pooled<data_type>(pool, segments);
+	queue.memcpy(dev_offsets.get(), offsets.data(), offsets.size()*sizeof(std::size_t)).wait();
+
+	report(samples::bench::run(opts, "segmented_reduce", type, size, bytes, size,
+		[&]
+		{
+			return samples::segmented_reduce(queue, in.get(), dev_offsets.get(), segments, seg_sums.get());
+		}
+	));
+	report(samples::bench::run(opts, "segmented_inclusive_scan", type, size, 2.0*bytes, size,
+		[&]
+		{
+			return samples::segmented_inclusive_scan(queue, in.get(), dev_offsets.get(), segments, out.get());
+		}
+	));
+
+	std::vector<data_type> got_sums(segments);
+	std::vector<ref_type> want_sums(segments);
+	queue.memcpy(got_sums.data(), seg_sums.get(), segments*sizeof(data_type));
+	queue.memcpy(got.data(), out.get(), bytes).wait();
+	for (std::size_t s=0; s<segments; s++)
+	{
+		ref_type running{};
+		for (std::size_t i=offsets[s]; i<offsets[s+1]; i++)
+		{
+			exclusive[i] = running;
+			running += raw[i];
+			inclusive[i] = running;
+		}
+		want_sums[s] = running;
+	}
+	ok = compare("segmented_reduce", type, got_sums, want_sums) && ok;
+	ok = compare("segmented_inclusive_scan", type, got, inclusive) && ok;
+
+	report(samples::bench::run(opts, "segmented_exclusive_scan", type, size, 2.0*bytes, size,
+		[&]
+		{
+			return samples::segmented_exclusive_scan(queue, in.get(), dev_offsets.get(), segments, out.get());
+		}
+	));
+	queue.memcpy(got.data(), out.get(), bytes).wait();
+	ok = compare("segmented_exclusive_scan", type, got, exclusive) && ok;
+	return ok;
+}
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	bool ok = bench_type<utx::ic32>(queue, pool, opts, report, "ic32");
+	ok = bench_type<utx::uc32>(queue, pool, opts, report, "uc32") && ok;
+	ok = bench_type<utx::fc32>(queue, pool, opts, report, "fc32") && ok;
+	queue.wait();
+	return ok ? 0 : 1;
+}
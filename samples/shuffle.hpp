@@ -0,0 +1,263 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::shuffle: local memory round trips against sub-group exchanges.
+//
+// Every kernel has a path::local_memory version, written like sycl-local-memory and
+// smart-pointer (store to a local_accessor, group_barrier, compute, group_barrier), and
+// barrier-free sub-group versions:
+//	transform    out[i] = op(in[i]). No item reads another item's value, so the sub-group
+//	             paths keep it in registers.
+//	neighbours   out[i] = w0 in[i-1] + w1 in[i] + w2 in[i+1], clamped at both ends.
+//	             path::sub_group gets the neighbours with shift_group_right/shift_group_left,
+//	             path::sub_group_select with select_from_group; the first and the last lane
+//	             of a sub-group read their outer neighbour from global memory.
+//	block_sums   out[b] = in[b*width] + ... + in[b*width+width-1] for a sub-group width of
+//	             8, 16 or 32. path::sub_group uses reduce_over_group, path::sub_group_select
+//	             a select_from_group butterfly; the kernels require sub-groups of width.
+// On cpu backends a sub-group is a set of SIMD lanes, so the sub-group paths become
+// register shuffles where the local memory path needs stores, loads and barriers.
+// op_type must be a named class: it is part of the kernel name.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "common.hpp"
+#include "tuner.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace samples::shuffle
+{
+
+enum class path
+{
+	local_memory,
+	sub_group,
+	sub_group_select,
+};
+
+constexpr const char * name(path p)
+{
+	return p == path::local_memory ? "local-memory" : p == path::sub_group ? "sub-group" : "sub-group-select";
+}
+
+inline std::size_t work_group(const sycl::queue & queue)
+{
+	return std::min<std::size_t>(256, capabilities(queue.get_device()).max_work_group_size);
+}
+
+inline bool supports_width(const sycl::queue & queue, std::size_t width)
+{
+	const auto & sizes = capabilities(queue.get_device()).sub_group_sizes;
+	return std::find(sizes.begin(), sizes.end(), width) != sizes.end();
+}
+
+template <path p, typename op_type>
+class transform_kernel;
+
+template <path p>
+class neighbours_kernel;
+
+template <path p, std::size_t width>
+class block_sums_kernel;
+
+template <path p, typename op_type>
+sycl::event transform(
+	sycl::queue & queue,
+	const utx::fc32 * in, utx::fc32 * out, std::size_t size,
+	op_type op,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	const std::size_t wg = work_group(queue);
+	const float * src = raw_pointer(in);
+	float * dst = raw_pointer(out);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			if constexpr (p == path::local_memory)
+			{
+				auto lm = sycl::local_accessor<float, 1>{sycl::range<1>{wg}, handler};
+				handler.parallel_for<transform_kernel<p, op_type>>(
+					sycl::nd_range<1>{round_up(size, wg), wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const std::size_t gid = item.get_global_id(0);
+						const std::size_t lid = item.get_local_id(0);
+						if (gid < size)
+							lm[lid] = src[gid];
+						sycl::group_barrier(item.get_group());
+						lm[lid] = op(lm[lid]);
+						sycl::group_barrier(item.get_group());
+						if (gid < size)
+							dst[gid] = lm[lid];
+					}
+				);
+			}
+			else
+			{
+				handler.parallel_for<transform_kernel<p, op_type>>(
+					sycl::nd_range<1>{round_up(size, wg), wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const std::size_t gid = item.get_global_id(0);
+						if (gid < size)
+							dst[gid] = op(src[gid]);
+					}
+				);
+			}
+		}
+	);
+}
+
+template <path p>
+sycl::event neighbours(
+	sycl::queue & queue,
+	const utx::fc32 * in, utx::fc32 * out, std::size_t size,
+	std::array<float, 3> w,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	if (size == 0)
+		return queue.submit([&] (sycl::handler & handler) { handler.depends_on(deps); });
+	const std::size_t wg = work_group(queue);
+	const float * src = raw_pointer(in);
+	float * dst = raw_pointer(out);
+	const std::size_t last = size-1;
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			if constexpr (p == path::local_memory)
+			{
+				// one halo element on each side of the group
+				auto lm = sycl::local_accessor<float, 1>{sycl::range<1>{wg+2}, handler};
+				handler.parallel_for<neighbours_kernel<p>>(
+					sycl::nd_range<1>{round_up(size, wg), wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const std::size_t gid = item.get_global_id(0);
+						const std::size_t lid = item.get_local_id(0);
+						lm[lid+1] = src[std::min(gid, last)];
+						if (lid == 0)
+							lm[0] = src[gid ? std::min(gid-1, last) : 0];
+						if (lid == wg-1)
+							lm[wg+1] = src[std::min(gid+1, last)];
+						sycl::group_barrier(item.get_group());
+						const float result = w[0]*lm[lid] + w[1]*lm[lid+1] + w[2]*lm[lid+2];
+						sycl::group_barrier(item.get_group());
+						if (gid < size)
+							dst[gid] = result;
+					}
+				);
+			}
+			else
+			{
+				handler.parallel_for<neighbours_kernel<p>>(
+					sycl::nd_range<1>{round_up(size, wg), wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const sycl::sub_group sg = item.get_sub_group();
+						const std::size_t gid = item.get_global_id(0);
+						const std::size_t lane = sg.get_local_linear_id();
+						const std::size_t lanes = sg.get_local_linear_range();
+						const float centre = src[std::min(gid, last)];
+						float left, right;
+						if constexpr (p == path::sub_group)
+						{
+							left = sycl::shift_group_right(sg, centre, 1);
+							right = sycl::shift_group_left(sg, centre, 1);
+						}
+						else
+						{
+							left = sycl::select_from_group(sg, centre, lane ? lane-1 : 0);
+							right = sycl::select_from_group(sg, centre, std::min(lane+1, lanes-1));
+						}
+						if (lane == 0)
+							left = src[gid ? std::min(gid-1, last) : 0];
+						if (lane == lanes-1)
+							right = src[std::min(gid+1, last)];
+						if (gid < size)
+							dst[gid] = w[0]*left + w[1]*centre + w[2]*right;
+					}
+				);
+			}
+		}
+	);
+}
+
+template <path p, std::size_t width>
+sycl::event block_sums(
+	sycl::queue & queue,
+	const utx::fc32 * in, utx::fc32 * out, std::size_t size,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	static_assert(width == 8 || width == 16 || width == 32);
+	if (p != path::local_memory && ! supports_width(queue, width))
+		throw std::invalid_argument{"samples::shuffle::block_sums: no sub-groups of this width on the device"};
+	const std::size_t wg = std::max(work_group(queue)/width*width, width);
+	const float * src = raw_pointer(in);
+	float * dst = raw_pointer(out);
+	const std::size_t blocks = (size+width-1)/width;
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			if constexpr (p == path::local_memory)
+			{
+				auto lm = sycl::local_accessor<float, 1>{sycl::range<1>{wg}, handler};
+				handler.parallel_for<block_sums_kernel<p, width>>(
+					sycl::nd_range<1>{round_up(blocks*width, wg), wg},
+					[=] (sycl::nd_item<1> item)
+					{
+						const std::size_t gid = item.get_global_id(0);
+						const std::size_t lid = item.get_local_id(0);
+						lm[lid] = gid < size ? src[gid] : 0.0f;
+						sycl::group_barrier(item.get_group());
+						for (std::size_t stride=width/2; stride>0; stride/=2)
+						{
+							if (lid%width < stride)
+								lm[lid] += lm[lid+stride];
+							sycl::group_barrier(item.get_group());
+						}
+						if (lid%width == 0 && gid/width < blocks)
+							dst[gid/width] = lm[lid];
+					}
+				);
+			}
+			else
+			{
+				handler.parallel_for<block_sums_kernel<p, width>>(
+					sycl::nd_range<1>{round_up(blocks*width, wg), wg},
+					[=] (sycl::nd_item<1> item) [[sycl::reqd_sub_group_size(width)]]
+					{
+						const sycl::sub_group sg = item.get_sub_group();
+						const std::size_t gid = item.get_global_id(0);
+						const std::size_t lane = sg.get_local_linear_id();
+						float sum = gid < size ? src[gid] : 0.0f;
+						if constexpr (p == path::sub_group)
+							sum = sycl::reduce_over_group(sg, sum, sycl::plus<float>{});
+						else
+							for (std::size_t stride=width/2; stride>0; stride/=2)
+								sum += sycl::select_from_group(sg, sum, lane ^ stride);
+						if (lane == 0 && gid/width < blocks)
+							dst[gid/width] = sum;
+					}
+				);
+			}
+		}
+	);
+}
+
+} // namespace samples::shuffle
@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// CSR, ELL and SELL-C-sigma SpMV and CSR SpMM (see sparse.hpp).
+//
+//	sparse-matrix --size=16777216 --warmup=2 --repeat=10 --format=csv
+//	sparse-matrix matrix.mtx --warmup=2 --repeat=10
+//
+// Without a Matrix Market file, three synthetic matrices with size/16 rows and 16 entries
+// per row on average are used: uniform rows, and power-law rows with alpha 3 and 2.2.
+// ELL is skipped when its padding would more than quadruple the entries.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "matrix-market.hpp"
+#include "sparse.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sparse = samples::sparse;
+using data_type = utx::fc32;
+
+constexpr std::size_t spmm_columns = 8;
+
+int main(int argc, char * argv[])
+{
+	std::string path;
+	if (argc > 1 && argv[1][0] != '-')
+	{
+		path = argv[1];
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	std::vector<std::pair<std::string, sparse::csr_host<data_type>>> matrices;
+	if (! path.empty())
+		matrices.emplace_back("mtx", sparse::read_matrix_market<data_type>(path));
+	else
+	{
+		const std::size_t rows = std::max<std::size_t>(opts.size/16, 1);
+		matrices.emplace_back("uniform", sparse::power_law<data_type>(rows, rows, 16, 0));
+		matrices.emplace_back("power-3.0", sparse::power_law<data_type>(rows, rows, 16, 3.0));
+		matrices.emplace_back("power-2.2", sparse::power_law<data_type>(rows, rows, 16, 2.2));
+	}
+
+	bool ok = true;
+	for (const auto & [label, host]: matrices)
+	{
+		const std::size_t rows = host.rows, cols = host.cols, nnz = host.nnz();
+		utx::printe(label, "rows:", rows, "cols:", cols, "nnz:", nnz);
+
+		std::vector<data_type> host_x(cols*spmm_columns), host_y(rows*spmm_columns);
+		for (std::size_t i=0; i<host_x.size(); i++)
+			host_x[i] = static_cast<float>(i%7)/7.0f;
+		auto x = sparse::copy_to_device(queue, pool, host_x);
+		auto y = samples::make_pooled<data_type>(pool, rows*spmm_columns);
+		const auto a = sparse::to_device(queue, pool, host);
+
+		std::vector<data_type> spmv_x(cols);
+		for (std::size_t i=0; i<cols; i++)
+			spmv_x[i] = static_cast<float>(i%5)/5.0f;
+		auto xv = sparse::copy_to_device(queue, pool, spmv_x);
+		queue.wait();
+
+		// double precision references of y = A x and Y = A X
+		std::vector<double> want_spmv(rows, 0.0), want_spmm(rows*spmm_columns, 0.0);
+		for (std::size_t r=0; r<rows; r++)
+			for (std::size_t e=host.row_offsets[r]; e<host.row_offsets[r+1]; e++)
+			{
+				const double v = host.values[e]();
+				const std::size_t c = host.col_indices[e];
+				want_spmv[r] += v*spmv_x[c]();
+				for (std::size_t j=0; j<spmm_columns; j++)
+					want_spmm[r*spmm_columns+j] += v*host_x[c*spmm_columns+j]();
+			}
+
+		auto check = [&] (const std::string & name, const std::vector<double> & want)
+		{
+			queue.memcpy(host_y.data(), y.get(), want.size()*sizeof(data_type)).wait();
+			for (std::size_t i=0; i<want.size(); i++)
+				if (std::abs(host_y[i]() - want[i]) > 1e-4*(1+std::abs(want[i])))
+				{
+					utx::printe(name, "FAILED at", i, host_y[i], "!=", want[i]);
+					return false;
+				}
+			return true;
+		};
+
+		const double flops = 2.0*nnz;
+		const double bytes = nnz*(2.0*sizeof(data_type) + sizeof(sparse::index_type)) +
+			rows*(sizeof(std::size_t) + sizeof(data_type));
+		const std::string suffix = "-" + label;
+
+		report(samples::bench::run(opts, "spmv-csr-rows"+suffix, "fc32", nnz, bytes, flops,
+			[&] { return sparse::spmv_rows(queue, a, xv.get(), y.get()); }));
+		ok = check("spmv-csr-rows"+suffix, want_spmv) && ok;
+
+		report(samples::bench::run(opts, "spmv-csr-sub-group"+suffix, "fc32", nnz, bytes, flops,
+			[&] { return sparse::spmv_sub_group(queue, a, xv.get(), y.get()); }));
+		ok = check("spmv-csr-sub-group"+suffix, want_spmv) && ok;
+
+		const auto ell_layout = sparse::to_ell(host);
+		if (ell_layout.width*rows <= 4*nnz)
+		{
+			const auto ell = sparse::to_device(queue, pool, ell_layout);
+			const double ell_bytes = ell_layout.width*rows*(2.0*sizeof(data_type) + sizeof(sparse::index_type)) +
+				rows*sizeof(data_type);
+			report(samples::bench::run(opts, "spmv-ell"+suffix, "fc32", nnz, ell_bytes, flops,
+				[&] { return sparse::spmv(queue, ell, xv.get(), y.get()); }));
+			ok = check("spmv-ell"+suffix, want_spmv) && ok;
+		}
+		else
+			utx::printe("spmv-ell"+suffix, "skipped, width:", ell_layout.width);
+
+		const auto sell_layout = sparse::to_sell(host, 32, 256);
+		const auto sell = sparse::to_device(queue, pool, sell_layout);
+		utx::printe("sell-32-256"+suffix, "stored:", sell.stored, "padding:", sell.stored - nnz);
+		report(samples::bench::run(opts, "spmv-sell-32-256"+suffix, "fc32", nnz, bytes, flops,
+			[&] { return sparse::spmv(queue, sell, xv.get(), y.get()); }));
+		ok = check("spmv-sell-32-256"+suffix, want_spmv) && ok;
+
+		report(samples::bench::run(opts, "spmm-csr-"+std::to_string(spmm_columns)+suffix, "fc32", nnz,
+			nnz*(sizeof(data_type) + sizeof(sparse::index_type) + spmm_columns*sizeof(data_type)) +
+				rows*spmm_columns*sizeof(data_type),
+			flops*spmm_columns,
+			[&] { return sparse::spmm(queue, a, x.get(), y.get(), spmm_columns); }));
+		ok = check("spmm-csr"+suffix, want_spmm) && ok;
+	}
+	return ok ? 0 : 1;
+}
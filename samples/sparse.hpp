@@ -0,0 +1,497 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::sparse: CSR, ELL and SELL-C-sigma matrices with SpMV (y = A x) and
+// CSR SpMM (Y = A X, X and Y dense row-major) on usm memory.
+//
+//	csr    row_offsets[rows+1], col_indices[nnz], values[nnz]
+//	ell    every row padded to width entries, stored column by column: [j*rows + r]
+//	sell   rows sorted by length inside windows of sigma rows, then cut into chunks of
+//	       c rows; every chunk is an ell block as wide as its longest row.
+//
+// spmv_rows gives every row one work-item, which is fine for short, even rows.
+// spmv_sub_group gives every row one sub-group, whose lanes stride the row and meet in
+// reduce_over_group, so long rows of a power-law matrix do not stall a whole group.
+// The host types (csr_host, ...) are converted on the host and copied with to_device.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "tuner.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace samples::sparse
+{
+
+using index_type = std::uint32_t;
+
+template <typename data_type>
+struct csr_host
+{
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::vector<std::size_t> row_offsets; // rows+1
+	std::vector<index_type> col_indices;
+	std::vector<data_type> values;
+
+	std::size_t nnz() const
+	{
+		return values.size();
+	}
+	std::size_t row_length(std::size_t r) const
+	{
+		return row_offsets[r+1] - row_offsets[r];
+	}
+};
+
+template <typename data_type>
+struct ell_host
+{
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::size_t width = 0;
+	std::vector<index_type> col_indices; // width*rows, padding points at column 0
+	std::vector<data_type> values; // width*rows, padding is 0
+};
+
+template <typename data_type>
+struct sell_host
+{
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::size_t chunk = 0; // c
+	std::size_t sigma = 0;
+	std::vector<std::size_t> chunk_offsets; // chunks+1
+	std::vector<index_type> row_of_slot; // chunks*c, the row of every slot (>= rows for padding)
+	std::vector<index_type> col_indices;
+	std::vector<data_type> values;
+};
+
+// (row, col, value) triplets to csr, duplicates are summed.
+template <typename data_type>
+csr_host<data_type> from_triplets(
+	std::size_t rows, std::size_t cols,
+	std::vector<index_type> row, std::vector<index_type> col, std::vector<data_type> value
+)
+{
+	std::vector<std::size_t> order(row.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(),
+		[&] (std::size_t x, std::size_t y)
+		{
+			return row[x] != row[y] ? row[x] < row[y] : col[x] < col[y];
+		}
+	);
+	csr_host<data_type> csr;
+	csr.rows = rows;
+	csr.cols = cols;
+	csr.row_offsets.assign(rows+1, 0);
+	for (std::size_t e=0; e<order.size(); e++)
+	{
+		const std::size_t i = order[e];
+		if (row[i] >= rows || col[i] >= cols)
+			throw std::out_of_range{"samples::sparse::from_triplets: entry outside the matrix"};
+		if (e > 0 && row[order[e-1]] == row[i] && col[order[e-1]] == col[i])
+		{
+			csr.values.back() += value[i];
+			continue;
+		}
+		csr.col_indices.push_back(col[i]);
+		csr.values.push_back(value[i]);
+		csr.row_offsets[row[i]+1]++;
+	}
+	std::partial_sum(csr.row_offsets.begin(), csr.row_offsets.end(), csr.row_offsets.begin());
+	return csr;
+}
+
+// rows x cols matrix whose row lengths follow a pareto (power-law) distribution with
+// exponent alpha > 2 and mean close to average; alpha 0 gives every row average entries.
+// Columns are uniform, values uniform in [-1, 1].
+template <typename data_type>
+csr_host<data_type> power_law(std::size_t rows, std::size_t cols, double average, double alpha, unsigned seed = 2023)
+{
+	std::mt19937_64 gen{seed};
+	std::uniform_real_distribution<double> unit{0.0, 1.0};
+	std::uniform_int_distribution<index_type> column{0, static_cast<index_type>(cols-1)};
+	std::uniform_real_distribution<double> value{-1.0, 1.0};
+	const double minimum = alpha > 2 ? average*(alpha-2)/(alpha-1) : average;
+
+	csr_host<data_type> csr;
+	csr.rows = rows;
+	csr.cols = cols;
+	csr.row_offsets.assign(rows+1, 0);
+	std::vector<index_type> row_cols;
+	for (std::size_t r=0; r<rows; r++)
+	{
+		double length = minimum;
+		if (alpha > 2)
+			length = minimum*std::pow(1.0-unit(gen), -1.0/(alpha-1));
+		const std::size_t count = std::min<std::size_t>(std::llround(length), cols);
+		row_cols.clear();
+		for (std::size_t e=0; e<count; e++)
+			row_cols.push_back(column(gen));
+		std::sort(row_cols.begin(), row_cols.end());
+		row_cols.erase(std::unique(row_cols.begin(), row_cols.end()), row_cols.end());
+		for (index_type c: row_cols)
+		{
+			csr.col_indices.push_back(c);
+			csr.values.push_back(data_type(static_cast<raw_value_t<data_type>>(value(gen))));
+		}
+		csr.row_offsets[r+1] = csr.col_indices.size();
+	}
+	return csr;
+}
+
+template <typename data_type>
+ell_host<data_type> to_ell(const csr_host<data_type> & csr)
+{
+	ell_host<data_type> ell;
+	ell.rows = csr.rows;
+	ell.cols = csr.cols;
+	for (std::size_t r=0; r<csr.rows; r++)
+		ell.width = std::max(ell.width, csr.row_length(r));
+	ell.col_indices.assign(ell.width*ell.rows, 0);
+	ell.values.assign(ell.width*ell.rows, data_type(0));
+	for (std::size_t r=0; r<csr.rows; r++)
+		for (std::size_t j=0; j<csr.row_length(r); j++)
+		{
+			ell.col_indices[j*ell.rows + r] = csr.col_indices[csr.row_offsets[r]+j];
+			ell.values[j*ell.rows + r] = csr.values[csr.row_offsets[r]+j];
+		}
+	return ell;
+}
+
+template <typename data_type>
+sell_host<data_type> to_sell(const csr_host<data_type> & csr, std::size_t chunk, std::size_t sigma)
+{
+	sigma = round_up(std::max(sigma, chunk), chunk);
+	sell_host<data_type> sell;
+	sell.rows = csr.rows;
+	sell.cols = csr.cols;
+	sell.chunk = chunk;
+	sell.sigma = sigma;
+
+	std::vector<index_type> order(round_up(csr.rows, chunk));
+	std::iota(order.begin(), order.end(), 0);
+	auto length = [&] (index_type r)
+	{
+		return r < csr.rows ? csr.row_length(r) : 0;
+	};
+	for (std::size_t w=0; w<order.size(); w+=sigma)
+		std::stable_sort(order.begin()+w, order.begin()+std::min(w+sigma, order.size()),
+			[&] (index_type x, index_type y)
+			{
+				return length(x) > length(y);
+			}
+		);
+
+	const std::size_t chunks = order.size()/chunk;
+	sell.chunk_offsets.assign(chunks+1, 0);
+	sell.row_of_slot = order;
+	for (std::size_t c=0; c<chunks; c++)
+	{
+		std::size_t width = 0;
+		for (std::size_t s=0; s<chunk; s++)
+			width = std::max(width, length(order[c*chunk+s]));
+		sell.chunk_offsets[c+1] = sell.chunk_offsets[c] + width*chunk;
+	}
+	sell.col_indices.assign(sell.chunk_offsets.back(), 0);
+	sell.values.assign(sell.chunk_offsets.back(), data_type(0));
+	for (std::size_t c=0; c<chunks; c++)
+		for (std::size_t s=0; s<chunk; s++)
+		{
+			const index_type r = order[c*chunk+s];
+			for (std::size_t j=0; j<length(r); j++)
+			{
+				sell.col_indices[sell.chunk_offsets[c] + j*chunk + s] = csr.col_indices[csr.row_offsets[r]+j];
+				sell.values[sell.chunk_offsets[c] + j*chunk + s] = csr.values[csr.row_offsets[r]+j];
+			}
+		}
+	return sell;
+}
+
+template <typename data_type>
+pooled_ptr<data_type> copy_to_device(sycl::queue & queue, usm_pool & pool, const std::vector<data_type> & host)
+{
+	auto ptr = make_pooled<data_type>(pool, std::max<std::size_t>(host.size(), 1));
+	if (! host.empty())
+		queue.memcpy(ptr.get(), host.data(), host.size()*sizeof(data_type));
+	return ptr;
+}
+
+// Device copies; the pointers stay valid as long as the object and its pool.
+template <typename data_type>
+struct csr
+{
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::size_t nnz = 0;
+	pooled_ptr<std::size_t> row_offsets;
+	pooled_ptr<index_type> col_indices;
+	pooled_ptr<data_type> values;
+};
+
+template <typename data_type>
+struct ell
+{
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::size_t width = 0;
+	pooled_ptr<index_type> col_indices;
+	pooled_ptr<data_type> values;
+};
+
+template <typename data_type>
+struct sell
+{
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::size_t chunk = 0;
+	std::size_t chunks = 0;
+	std::size_t stored = 0; // entries including padding
+	pooled_ptr<std::size_t> chunk_offsets;
+	pooled_ptr<index_type> row_of_slot;
+	pooled_ptr<index_type> col_indices;
+	pooled_ptr<data_type> values;
+};
+
+template <typename data_type>
+csr<data_type> to_device(sycl::queue & queue, usm_pool & pool, const csr_host<data_type> & host)
+{
+	csr<data_type> dev{host.rows, host.cols, host.nnz(),
+		copy_to_device(queue, pool, host.row_offsets),
+		copy_to_device(queue, pool, host.col_indices),
+		copy_to_device(queue, pool, host.values)};
+	queue.wait();
+	return dev;
+}
+
+template <typename data_type>
+ell<data_type> to_device(sycl::queue & queue, usm_pool & pool, const ell_host<data_type> & host)
+{
+	ell<data_type> dev{host.rows, host.cols, host.width,
+		copy_to_device(queue, pool, host.col_indices),
+		copy_to_device(queue, pool, host.values)};
+	queue.wait();
+	return dev;
+}
+
+template <typename data_type>
+sell<data_type> to_device(sycl::queue & queue, usm_pool & pool, const sell_host<data_type> & host)
+{
+	sell<data_type> dev{host.rows, host.cols, host.chunk, host.chunk_offsets.size()-1, host.values.size(),
+		copy_to_device(queue, pool, host.chunk_offsets),
+		copy_to_device(queue, pool, host.row_of_slot),
+		copy_to_device(queue, pool, host.col_indices),
+		copy_to_device(queue, pool, host.values)};
+	queue.wait();
+	return dev;
+}
+
+template <typename raw_type, int variant>
+class spmv_kernel;
+
+template <typename raw_type>
+class spmm_kernel;
+
+// y = A x, one work-item per row
+template <typename data_type>
+sycl::event spmv_rows(
+	sycl::queue & queue,
+	const csr<data_type> & a, const data_type * x, data_type * y,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t * offsets = a.row_offsets.get();
+	const index_type * cols = a.col_indices.get();
+	const raw_type * values = raw_pointer(a.values.get());
+	const raw_type * in = raw_pointer(x);
+	raw_type * out = raw_pointer(y);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<spmv_kernel<raw_type, 0>>(
+				sycl::range<1>{a.rows},
+				[=] (sycl::id<1> id)
+				{
+					const std::size_t r = id[0];
+					raw_type sum = 0;
+					for (std::size_t e=offsets[r]; e<offsets[r+1]; e++)
+						sum += values[e]*in[cols[e]];
+					out[r] = sum;
+				}
+			);
+		}
+	);
+}
+
+// y = A x, one sub-group per row
+template <typename data_type>
+sycl::event spmv_sub_group(
+	sycl::queue & queue,
+	const csr<data_type> & a, const data_type * x, data_type * y,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const device_caps & caps = capabilities(queue.get_device());
+	const std::size_t wg = std::min<std::size_t>(256, caps.max_work_group_size);
+	const std::size_t sub_group = caps.sub_group_sizes.empty() ? 1 : caps.sub_group_sizes.front();
+	// rows beyond the launch are picked up by the grid-stride loop
+	const std::size_t groups = std::clamp<std::size_t>((a.rows*sub_group+wg-1)/wg, 1, caps.compute_units*64);
+	const std::size_t rows = a.rows;
+	const std::size_t * offsets = a.row_offsets.get();
+	const index_type * cols = a.col_indices.get();
+	const raw_type * values = raw_pointer(a.values.get());
+	const raw_type * in = raw_pointer(x);
+	raw_type * out = raw_pointer(y);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<spmv_kernel<raw_type, 1>>(
+				sycl::nd_range<1>{groups*wg, wg},
+				[=] (sycl::nd_item<1> item)
+				{
+					const sycl::sub_group sg = item.get_sub_group();
+					const std::size_t lanes = sg.get_local_linear_range();
+					const std::size_t lane = sg.get_local_linear_id();
+					const std::size_t per_group = sg.get_group_linear_range();
+					for (std::size_t r=item.get_group(0)*per_group + sg.get_group_linear_id(); r<rows;
+						r+=item.get_group_range(0)*per_group)
+					{
+						raw_type sum = 0;
+						for (std::size_t e=offsets[r]+lane; e<offsets[r+1]; e+=lanes)
+							sum += values[e]*in[cols[e]];
+						sum = sycl::reduce_over_group(sg, sum, sycl::plus<raw_type>{});
+						if (lane == 0)
+							out[r] = sum;
+					}
+				}
+			);
+		}
+	);
+}
+
+// y = A x, one work-item per row, coalesced over the padded columns
+template <typename data_type>
+sycl::event spmv(
+	sycl::queue & queue,
+	const ell<data_type> & a, const data_type * x, data_type * y,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t rows = a.rows, width = a.width;
+	const index_type * cols = a.col_indices.get();
+	const raw_type * values = raw_pointer(a.values.get());
+	const raw_type * in = raw_pointer(x);
+	raw_type * out = raw_pointer(y);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<spmv_kernel<raw_type, 2>>(
+				sycl::range<1>{rows},
+				[=] (sycl::id<1> id)
+				{
+					const std::size_t r = id[0];
+					raw_type sum = 0;
+					for (std::size_t j=0; j<width; j++)
+						sum += values[j*rows+r]*in[cols[j*rows+r]];
+					out[r] = sum;
+				}
+			);
+		}
+	);
+}
+
+// y = A x, one work-item per slot of a chunk
+template <typename data_type>
+sycl::event spmv(
+	sycl::queue & queue,
+	const sell<data_type> & a, const data_type * x, data_type * y,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t rows = a.rows, chunk = a.chunk;
+	const std::size_t * offsets = a.chunk_offsets.get();
+	const index_type * row_of_slot = a.row_of_slot.get();
+	const index_type * cols = a.col_indices.get();
+	const raw_type * values = raw_pointer(a.values.get());
+	const raw_type * in = raw_pointer(x);
+	raw_type * out = raw_pointer(y);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<spmv_kernel<raw_type, 3>>(
+				sycl::range<1>{a.chunks*chunk},
+				[=] (sycl::id<1> id)
+				{
+					const std::size_t c = id[0]/chunk, s = id[0]%chunk;
+					const std::size_t r = row_of_slot[id[0]];
+					if (r >= rows)
+						return;
+					raw_type sum = 0;
+					for (std::size_t e=offsets[c]+s; e<offsets[c+1]; e+=chunk)
+						sum += values[e]*in[cols[e]];
+					out[r] = sum;
+				}
+			);
+		}
+	);
+}
+
+// Y = A X; X is a.cols x n and Y is a.rows x n, both row-major.
+// One work-item per element of Y: neighbouring items share the entries of A and
+// read neighbouring elements of X.
+template <typename data_type>
+sycl::event spmm(
+	sycl::queue & queue,
+	const csr<data_type> & a, const data_type * x, data_type * y, std::size_t n,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	using raw_type = raw_value_t<data_type>;
+	const std::size_t * offsets = a.row_offsets.get();
+	const index_type * cols = a.col_indices.get();
+	const raw_type * values = raw_pointer(a.values.get());
+	const raw_type * in = raw_pointer(x);
+	raw_type * out = raw_pointer(y);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<spmm_kernel<raw_type>>(
+				sycl::range<2>{a.rows, n},
+				[=] (sycl::id<2> id)
+				{
+					const std::size_t r = id[0], j = id[1];
+					raw_type sum = 0;
+					for (std::size_t e=offsets[r]; e<offsets[r+1]; e++)
+						sum += values[e]*in[cols[e]*n+j];
+					out[r*n+j] = sum;
+				}
+			);
+		}
+	);
+}
+
+} // namespace samples::sparse
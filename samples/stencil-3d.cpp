@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// 3d stencils with a local memory halo against the naive per-point version (see stencil.hpp).
+//
+//	stencil-3d --size=16777216 --warmup=1 --repeat=5 --format=csv
+//
+// --size is the number of grid points, the grid is a cube. Every run does 16 timesteps.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "stencil.hpp"
+#include "tuner.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace stencil = samples::stencil;
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+
+	constexpr std::size_t steps = 16;
+	const std::size_t side = std::max<std::size_t>(std::lround(std::cbrt(static_cast<double>(opts.size))), 3);
+	const sycl::range<3> extents{side, side, side};
+	const std::size_t size = extents.size();
+	const std::size_t bytes = size*sizeof(utx::fc32);
+
+	const auto & caps = samples::capabilities(queue.get_device());
+	const sycl::range<3> tile = caps.max_work_group_size >= 512 ?
+		sycl::range<3>{8, 8, 8} : sycl::range<3>{4, 8, 8};
+	const double halo_reads = static_cast<double>((tile[0]+2)*(tile[1]+2)*(tile[2]+2))/tile.size();
+
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+	auto a = samples::make_pooled<utx::fc32>(pool, size);
+	auto b = samples::make_pooled<utx::fc32>(pool, size);
+	auto c = samples::make_pooled<utx::fc32>(pool, size);
+	auto d = samples::make_pooled<utx::fc32>(pool, size);
+
+	std::vector<utx::fc32> init(size);
+	for (std::size_t i=0; i<size; i++)
+		init[i] = static_cast<float>(i%101)/100;
+
+	const stencil::weights<utx::fc32> w7{0.4f, 0.1f};
+	const stencil::weights<utx::fc32> w27{0.2f, 0.05f, 0.025f, 0.0125f};
+
+	auto bench = [&] <int points> (const stencil::weights<utx::fc32> & w)
+	{
+		const std::string name = "stencil-" + std::to_string(points) + "pt-";
+		utx::fc32 * naive_result = nullptr, * tiled_result = nullptr;
+
+		// Global reads per point are points for the naive kernel and the halo ratio for the
+		// tiled one; both write once. bytes are the global traffic of all steps.
+		report(samples::bench::run(opts, name+"naive", "fc32", size,
+			steps*(points+1.0)*bytes, steps*2.0*points*size,
+			[&]
+			{
+				queue.memcpy(a.get(), init.data(), bytes).wait();
+				auto [result, events] = stencil::run<points>(queue, a.get(), b.get(), extents, w, steps, false);
+				naive_result = result;
+				return events;
+			}
+		));
+		report(samples::bench::run(opts, name+"tiled", "fc32", size,
+			steps*(halo_reads+1.0)*bytes, steps*2.0*points*size,
+			[&]
+			{
+				queue.memcpy(c.get(), init.data(), bytes).wait();
+				auto [result, events] = stencil::run<points>(queue, c.get(), d.get(), extents, w, steps, true, tile);
+				tiled_result = result;
+				return events;
+			}
+		));
+
+		std::vector<utx::fc32> naive(size), tiled(size);
+		queue.memcpy(naive.data(), naive_result, bytes);
+		queue.memcpy(tiled.data(), tiled_result, bytes).wait();
+		double diff = 0;
+		for (std::size_t i=0; i<size; i++)
+			diff = std::max(diff, std::abs(static_cast<double>(naive[i]()) - tiled[i]()));
+		utx::printe(name+"tiled", "global reads per point:", halo_reads, "instead of", points,
+			"max |naive - tiled|:", diff);
+	};
+
+	bench.template operator()<7>(w7);
+	bench.template operator()<27>(w27);
+}
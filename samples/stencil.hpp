@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::stencil: 7-point and 27-point 3d stencils on usm grids.
+//
+//	out[p] = center*in[p] + face*(6 face neighbours)
+//	       + edge*(12 edge neighbours) + corner*(8 corner neighbours)  (27-point only)
+//
+// The tiled step loads the work-group tile plus a one point halo into local
+// memory cooperatively, then every item reads its neighbours from there, so a
+// point is read from global memory about (t+2)^3/t^3 times instead of 7 or 27
+// times. Boundary points are copied unchanged (fixed boundary condition).
+// samples::stencil::run does many timesteps, ping-ponging two grids.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace samples::stencil
+{
+
+template <typename data_type>
+struct weights
+{
+	data_type center;
+	data_type face;
+	data_type edge = data_type(0);
+	data_type corner = data_type(0);
+};
+
+template <typename data_type, int points, bool tiled>
+class stencil_kernel;
+
+// Weighted sum around (i0, i1, i2); at(d0, d1, d2) returns the neighbour at that offset.
+template <int points, typename data_type, typename at_type>
+data_type apply(const weights<data_type> & w, at_type && at)
+{
+	static_assert(points == 7 || points == 27, "samples::stencil supports 7 and 27 points");
+	data_type faces = at(-1,0,0) + at(1,0,0) + at(0,-1,0) + at(0,1,0) + at(0,0,-1) + at(0,0,1);
+	data_type sum = w.center*at(0,0,0) + w.face*faces;
+	if constexpr (points == 27)
+	{
+		data_type edges = data_type(0), corners = data_type(0);
+		for (int d0=-1; d0<=1; d0++)
+			for (int d1=-1; d1<=1; d1++)
+				for (int d2=-1; d2<=1; d2++)
+				{
+					const int distance = (d0 != 0) + (d1 != 0) + (d2 != 0);
+					if (distance == 2)
+						edges += at(d0, d1, d2);
+					else if (distance == 3)
+						corners += at(d0, d1, d2);
+				}
+		sum += w.edge*edges + w.corner*corners;
+	}
+	return sum;
+}
+
+// One timestep reading every neighbour from global memory.
+template <int points, typename data_type>
+sycl::event step_naive(
+	sycl::queue & queue,
+	const data_type * in, data_type * out,
+	sycl::range<3> extents,
+	weights<data_type> w,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<stencil_kernel<data_type, points, false>>(
+				extents,
+				[=] (sycl::id<3> id)
+				{
+					const std::size_t n0 = extents[0], n1 = extents[1], n2 = extents[2];
+					const std::size_t i0 = id[0], i1 = id[1], i2 = id[2];
+					const std::size_t index = (i0*n1+i1)*n2+i2;
+					if (i0 == 0 || i1 == 0 || i2 == 0 || i0 == n0-1 || i1 == n1-1 || i2 == n2-1)
+					{
+						out[index] = in[index];
+						return;
+					}
+					out[index] = apply<points>(w,
+						[&] (int d0, int d1, int d2)
+						{
+							return in[((i0+d0)*n1+(i1+d1))*n2+(i2+d2)];
+						}
+					);
+				}
+			);
+		}
+	);
+}
+
+// One timestep through a local memory tile with halo.
+template <int points, typename data_type>
+sycl::event step_tiled(
+	sycl::queue & queue,
+	const data_type * in, data_type * out,
+	sycl::range<3> extents,
+	weights<data_type> w,
+	sycl::range<3> tile,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	const sycl::range<3> global{
+		samples::round_up(extents[0], tile[0]),
+		samples::round_up(extents[1], tile[1]),
+		samples::round_up(extents[2], tile[2])
+	};
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			const sycl::range<3> halo{tile[0]+2, tile[1]+2, tile[2]+2};
+			auto lm = sycl::local_accessor<data_type, 3>{halo, handler};
+			handler.parallel_for<stencil_kernel<data_type, points, true>>(
+				sycl::nd_range<3>{global, tile},
+				[=] (sycl::nd_item<3> item)
+				{
+					const std::size_t n0 = extents[0], n1 = extents[1], n2 = extents[2];
+					const std::size_t h1 = halo[1], h2 = halo[2];
+					const std::size_t volume = halo.size();
+
+					// origin of the halo block in the grid, may be -1 at the low edges
+					const long o0 = static_cast<long>(item.get_group(0)*tile[0]) - 1;
+					const long o1 = static_cast<long>(item.get_group(1)*tile[1]) - 1;
+					const long o2 = static_cast<long>(item.get_group(2)*tile[2]) - 1;
+
+					for (std::size_t e=item.get_local_linear_id(); e<volume; e+=item.get_local_range().size())
+					{
+						const std::size_t l0 = e/(h1*h2), l1 = e/h2%h1, l2 = e%h2;
+						const long g0 = o0+static_cast<long>(l0), g1 = o1+static_cast<long>(l1), g2 = o2+static_cast<long>(l2);
+						const bool inside =
+							g0 >= 0 && g1 >= 0 && g2 >= 0 &&
+							g0 < static_cast<long>(n0) && g1 < static_cast<long>(n1) && g2 < static_cast<long>(n2);
+						lm[l0][l1][l2] = inside ? in[(g0*n1+g1)*n2+g2] : data_type(0);
+					}
+					sycl::group_barrier(item.get_group());
+
+					const std::size_t i0 = item.get_global_id(0);
+					const std::size_t i1 = item.get_global_id(1);
+					const std::size_t i2 = item.get_global_id(2);
+					if (i0 >= n0 || i1 >= n1 || i2 >= n2)
+						return;
+
+					const std::size_t l0 = item.get_local_id(0)+1;
+					const std::size_t l1 = item.get_local_id(1)+1;
+					const std::size_t l2 = item.get_local_id(2)+1;
+					const std::size_t index = (i0*n1+i1)*n2+i2;
+					if (i0 == 0 || i1 == 0 || i2 == 0 || i0 == n0-1 || i1 == n1-1 || i2 == n2-1)
+					{
+						out[index] = lm[l0][l1][l2];
+						return;
+					}
+					out[index] = apply<points>(w,
+						[&] (int d0, int d1, int d2)
+						{
+							return lm[l0+d0][l1+d1][l2+d2];
+						}
+					);
+				}
+			);
+		}
+	);
+}
+
+// steps timesteps from a into b and back; returns the grid holding the result
+// and the events of every step.
+template <int points, typename data_type>
+std::pair<data_type *, std::vector<sycl::event>> run(
+	sycl::queue & queue,
+	data_type * a, data_type * b,
+	sycl::range<3> extents,
+	weights<data_type> w,
+	std::size_t steps,
+	bool tiled,
+	sycl::range<3> tile = {8, 8, 8}
+)
+{
+	std::vector<sycl::event> events;
+	for (std::size_t s=0; s<steps; s++)
+	{
+		std::vector<sycl::event> deps;
+		if (! events.empty())
+			deps.push_back(events.back());
+		events.push_back(tiled ?
+			step_tiled<points>(queue, a, b, extents, w, tile, deps) :
+			step_naive<points>(queue, a, b, extents, w, deps)
+		);
+		std::swap(a, b);
+	}
+	return {a, std::move(events)};
+}
+
+} // namespace samples::stencil
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Out-of-core streaming of utx::sqrt and a sum through bounded device memory (see streaming.hpp).
+//
+//	streaming --size=268435456 --warmup=1 --repeat=5 --format=csv
+//
+// Every configuration streams the whole host array; depth 1 has no overlap.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include "bench.hpp"
+#include "streaming.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <string>
+
+struct sqrt_op
+{
+	utx::fc32 operator()(utx::fc32 x) const
+	{
+		return utx::sqrt(x);
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+
+	const std::size_t size = opts.size;
+	const std::size_t bytes = size*sizeof(utx::fc32);
+
+	samples::usm_pool device_pool{queue, sycl::usm::alloc::device};
+	samples::usm_pool host_pool{queue, sycl::usm::alloc::host};
+	auto in = samples::make_pooled<utx::fc32>(host_pool, size);
+	auto out = samples::make_pooled<utx::fc32>(host_pool, size);
+	for (std::size_t i=0; i<size; i++)
+		in[i] = static_cast<float>(i%1024);
+
+	bool ok = true;
+	for (std::size_t block: {std::size_t{1} << 18, std::size_t{1} << 20, std::size_t{1} << 22})
+	{
+		for (std::size_t depth: {1, 2, 3})
+		{
+			const samples::streaming::config conf{block, depth};
+			const std::string name = "block-" + std::to_string(block) + "-depth-" + std::to_string(depth);
+
+			report(samples::bench::run_host(opts, "stream-sqrt-"+name, "fc32", size, 2.0*bytes, size,
+				[&]
+				{
+					samples::streaming::transform(queue, device_pool, in.get(), out.get(), size, sqrt_op{}, conf);
+				}
+			));
+
+			utx::fc32 sum;
+			report(samples::bench::run_host(opts, "stream-sum-"+name, "fc32", size, bytes, size,
+				[&]
+				{
+					sum = samples::streaming::reduce(queue, device_pool, in.get(), size, sycl::plus<>{}, conf);
+				}
+			));
+
+			for (std::size_t i=0; i<size; i+=size/97+1)
+				if (std::abs(out[i]() - std::sqrt(static_cast<float>(i%1024))) > 1e-5f*(1+out[i]()))
+				{
+					utx::printe("stream-sqrt-"+name, "FAILED at", i);
+					ok = false;
+					break;
+				}
+			const double rest = size%1024;
+			const double want = (size/1024)*(1023.0*1024/2) + rest*(rest-1)/2;
+			if (std::abs(sum() - want) > 1e-3*want)
+			{
+				utx::printe("stream-sum-"+name, "FAILED:", sum, "!=", want);
+				ok = false;
+			}
+			utx::printe(name, "device bytes:", samples::streaming::device_bytes<utx::fc32, utx::fc32>(size, conf),
+				"host bytes:", 2*bytes);
+		}
+	}
+	return ok ? 0 : 1;
+}
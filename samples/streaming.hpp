@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::streaming: out-of-core elementwise transform and reduce.
+//
+//	The host input is cut into blocks of config::block elements. config::depth
+//	device slots are used round robin, and every block is a chain of three commands
+//	tied by events only:
+//		copy in (host -> slot)  ->  kernel  ->  copy out (slot -> host)
+//	Block b reuses the slot of block b-depth, so its copy in waits for that kernel
+//	and its kernel waits for that copy out. With depth 2 or 3 the copies of one
+//	block overlap the kernel of another, and device memory stays at
+//	depth*block elements however large the input is.
+//	Host memory from sycl::malloc_host (or a host samples::usm_pool) copies fastest.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "group-algorithms.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace samples::streaming
+{
+
+struct config
+{
+	std::size_t block = std::size_t{1} << 20; // elements per block
+	std::size_t depth = 2; // blocks in flight
+};
+
+// device bytes held by a stream of in_type to out_type
+template <typename in_type, typename out_type>
+std::size_t device_bytes(std::size_t size, const config & conf)
+{
+	const std::size_t block = std::min(conf.block, size);
+	return std::max<std::size_t>(conf.depth, 1)*block*(sizeof(in_type)+sizeof(out_type));
+}
+
+template <typename in_type, typename out_type, typename op_type>
+class transform_kernel
+{
+private:
+	const in_type * in;
+	out_type * out;
+	op_type op;
+public:
+	transform_kernel(const in_type * in, out_type * out, op_type op):
+		in{in},
+		out{out},
+		op{op}
+	{
+	}
+	void operator()(sycl::id<1> id) const
+	{
+		out[id[0]] = op(in[id[0]]);
+	}
+};
+
+// out[i] = op(in[i]) for i in [0, size); in and out are host memory.
+template <typename in_type, typename out_type, typename op_type>
+void transform(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const in_type * in, out_type * out, std::size_t size,
+	op_type op,
+	const config & conf = {}
+)
+{
+	if (size == 0)
+		return;
+	const std::size_t block = std::min(conf.block, size);
+	const std::size_t depth = std::max<std::size_t>(conf.depth, 1);
+
+	std::vector<pooled_ptr<in_type>> slot_in;
+	std::vector<pooled_ptr<out_type>> slot_out;
+	for (std::size_t s=0; s<depth; s++)
+	{
+		slot_in.push_back(make_pooled<in_type>(pool, block));
+		slot_out.push_back(make_pooled<out_type>(pool, block));
+	}
+	std::vector<sycl::event> computed(depth), copied_out(depth);
+
+	for (std::size_t b=0, offset=0; offset<size; b++, offset+=block)
+	{
+		const std::size_t s = b%depth;
+		const std::size_t count = std::min(block, size-offset);
+		in_type * d_in = slot_in[s].get();
+		out_type * d_out = slot_out[s].get();
+		const bool reused = b >= depth;
+
+		sycl::event copied_in = reused ?
+			queue.memcpy(d_in, in+offset, count*sizeof(in_type), computed[s]) :
+			queue.memcpy(d_in, in+offset, count*sizeof(in_type));
+		computed[s] = queue.submit(
+			[&] (sycl::handler & handler)
+			{
+				handler.depends_on(copied_in);
+				if (reused)
+					handler.depends_on(copied_out[s]);
+				handler.parallel_for(sycl::range<1>{count}, transform_kernel<in_type, out_type, op_type>{d_in, d_out, op});
+			}
+		);
+		copied_out[s] = queue.memcpy(out+offset, d_out, count*sizeof(out_type), computed[s]);
+	}
+
+	// the slots go back to the pool here, so every command using them must be done
+	for (std::size_t s=0; s<depth && s*block<size; s++)
+		copied_out[s].wait();
+}
+
+// op-reduction of in[0, size); in is host memory.
+template <typename data_type, typename op_type=sycl::plus<>>
+data_type reduce(
+	sycl::queue & queue,
+	usm_pool & pool,
+	const data_type * in, std::size_t size,
+	op_type op = {},
+	const config & conf = {}
+)
+{
+	const std::size_t block = std::min(conf.block, size);
+	const std::size_t depth = std::max<std::size_t>(conf.depth, 1);
+	const std::size_t blocks = block ? (size+block-1)/block : 0;
+
+	std::vector<pooled_ptr<data_type>> slot_in, slot_sum;
+	for (std::size_t s=0; s<depth; s++)
+	{
+		slot_in.push_back(make_pooled<data_type>(pool, block));
+		slot_sum.push_back(make_pooled<data_type>(pool, 1));
+	}
+	std::vector<sycl::event> reduced(depth), copied_out(depth);
+	std::vector<data_type> partials(blocks);
+
+	for (std::size_t b=0; b<blocks; b++)
+	{
+		const std::size_t s = b%depth;
+		const std::size_t offset = b*block;
+		const std::size_t count = std::min(block, size-offset);
+		const bool reused = b >= depth;
+
+		sycl::event copied_in = reused ?
+			queue.memcpy(slot_in[s].get(), in+offset, count*sizeof(data_type), reduced[s]) :
+			queue.memcpy(slot_in[s].get(), in+offset, count*sizeof(data_type));
+		std::vector<sycl::event> deps{copied_in};
+		if (reused)
+			deps.push_back(copied_out[s]);
+		reduced[s] = samples::reduce(queue, pool, slot_in[s].get(), count, slot_sum[s].get(), op, deps);
+		copied_out[s] = queue.memcpy(&partials[b], slot_sum[s].get(), sizeof(data_type), reduced[s]);
+	}
+	queue.wait();
+
+	data_type result = data_type(sycl::known_identity_v<op_type, raw_value_t<data_type>>);
+	for (const data_type & partial: partials)
+		result = op(result, partial);
+	return result;
+}
+
+} // namespace samples::streaming
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Local memory round trips against sub-group shuffles (see shuffle.hpp).
+//
+//	sub-group-shuffle --size=16777216 --warmup=2 --repeat=10 --format=csv
+//	ONEAPI_DEVICE_SELECTOR=opencl:cpu sub-group-shuffle     sub-groups as SIMD lanes
+//
+// transform (sqrt, as in sycl-local-memory), the 3-point neighbours kernel and block sums
+// of every sub-group width of the device run on all paths and are checked on the host.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "shuffle.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace shuffle = samples::shuffle;
+
+struct sqrt_op
+{
+	float operator()(float x) const
+	{
+		return sycl::sqrt(x);
+	}
+};
+
+class runner
+{
+private:
+	sycl::queue & queue;
+	const samples::bench::options & opts;
+	samples::bench::reporter & report;
+	std::size_t size;
+	const utx::fc32 * in;
+	utx::fc32 * out;
+	std::vector<utx::fc32> host_out;
+
+	bool check(const std::string & label, const std::vector<double> & want)
+	{
+		queue.memcpy(host_out.data(), out, want.size()*sizeof(utx::fc32)).wait();
+		for (std::size_t i=0; i<want.size(); i++)
+			if (std::abs(host_out[i]() - want[i]) > 1e-5*(1+std::abs(want[i])))
+			{
+				utx::printe(label, "FAILED at", i, host_out[i], "!=", want[i]);
+				return false;
+			}
+		return true;
+	}
+
+public:
+	runner(sycl::queue & queue, const samples::bench::options & opts, samples::bench::reporter & report,
+		std::size_t size, const utx::fc32 * in, utx::fc32 * out):
+		queue{queue},
+		opts{opts},
+		report{report},
+		size{size},
+		in{in},
+		out{out},
+		host_out(size)
+	{
+	}
+
+	template <shuffle::path p>
+	bool transform(const std::vector<double> & want)
+	{
+		const std::string label = std::string{"transform-"} + shuffle::name(p);
+		report(samples::bench::run(opts, label, "fc32", size, 2.0*size*sizeof(utx::fc32), size,
+			[&] { return shuffle::transform<p>(queue, in, out, size, sqrt_op{}); }));
+		return check(label, want);
+	}
+
+	template <shuffle::path p>
+	bool neighbours(const std::array<float, 3> & w, const std::vector<double> & want)
+	{
+		const std::string label = std::string{"neighbours-"} + shuffle::name(p);
+		report(samples::bench::run(opts, label, "fc32", size, 2.0*size*sizeof(utx::fc32), 5.0*size,
+			[&] { return shuffle::neighbours<p>(queue, in, out, size, w); }));
+		return check(label, want);
+	}
+
+	template <shuffle::path p, std::size_t width>
+	bool block_sums(const std::vector<double> & host_in)
+	{
+		const std::string label = "block-sums-" + std::to_string(width) + "-" + shuffle::name(p);
+		if (p != shuffle::path::local_memory && ! shuffle::supports_width(queue, width))
+		{
+			utx::printe(label, "skipped, no sub-groups of width", width);
+			return true;
+		}
+		const std::size_t blocks = (size+width-1)/width;
+		std::vector<double> want(blocks, 0.0);
+		for (std::size_t i=0; i<size; i++)
+			want[i/width] += host_in[i];
+		report(samples::bench::run(opts, label, "fc32", size, (size+blocks)*sizeof(utx::fc32), size,
+			[&] { return shuffle::block_sums<p, width>(queue, in, out, size); }));
+		return check(label, want);
+	}
+};
+
+template <std::size_t width>
+bool block_sums(runner & run, const std::vector<double> & host_in)
+{
+	bool ok = run.block_sums<shuffle::path::local_memory, width>(host_in);
+	ok = run.block_sums<shuffle::path::sub_group, width>(host_in) && ok;
+	return run.block_sums<shuffle::path::sub_group_select, width>(host_in) && ok;
+}
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t size = opts.size + 13;
+	std::vector<utx::fc32> host(size);
+	std::vector<double> host_in(size);
+	for (std::size_t i=0; i<size; i++)
+	{
+		host[i] = static_cast<float>(i%1000)/10.0f;
+		host_in[i] = host[i]();
+	}
+	auto in = samples::make_pooled<utx::fc32>(pool, size);
+	auto out = samples::make_pooled<utx::fc32>(pool, size);
+	queue.memcpy(in.get(), host.data(), size*sizeof(utx::fc32)).wait();
+	runner run{queue, opts, report, size, in.get(), out.get()};
+
+	std::vector<double> want(size);
+	for (std::size_t i=0; i<size; i++)
+		want[i] = std::sqrt(host_in[i]);
+	bool ok = run.transform<shuffle::path::local_memory>(want);
+	ok = run.transform<shuffle::path::sub_group>(want) && ok;
+	ok = run.transform<shuffle::path::sub_group_select>(want) && ok;
+
+	const std::array<float, 3> w{0.25f, 0.5f, 0.25f};
+	for (std::size_t i=0; i<size; i++)
+		want[i] = w[0]*host_in[i ? i-1 : 0] + w[1]*host_in[i] + w[2]*host_in[std::min(i+1, size-1)];
+	ok = run.neighbours<shuffle::path::local_memory>(w, want) && ok;
+	ok = run.neighbours<shuffle::path::sub_group>(w, want) && ok;
+	ok = run.neighbours<shuffle::path::sub_group_select>(w, want) && ok;
+
+	ok = block_sums<8>(run, host_in) && ok;
+	ok = block_sums<16>(run, host_in) && ok;
+	ok = block_sums<32>(run, host_in) && ok;
+	return ok ? 0 : 1;
+}
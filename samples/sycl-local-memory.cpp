@@ -9,13 +9,15 @@
 #include <utxcpp/core.hpp>
 #include <utxcpp/math.hpp>
 #include <utxcpp/algorithm.hpp>
+#include "trace.hpp"
 
 int main()
 {
+	samples::trace::session trace; // SAMPLES_TRACE=sycl-local-memory.json writes a chrome trace
 	sycl::device device{sycl::gpu_selector_v};
 	auto lmsize = device.get_info<sycl::info::device::local_mem_size>();
 	utx::print("max local memory size:", lmsize);
-	sycl::queue queue{device};
+	sycl::queue queue{device, samples::trace::queue_properties()};
 	
 	constexpr utx::uc32 gsize = 8; // global range will be 8x8
 	constexpr utx::uc32 lsize = 2; // local range will be 2x2
@@ -35,16 +37,17 @@ int main()
 
 	auto buffer = sycl::buffer<utx::fc32, 2>{vector.data(), sycl::range<2>{gsize, gsize}};
 
-	queue.submit(
+	const auto range = sycl::nd_range<2>{
+		sycl::range<2>{gsize, gsize},
+		sycl::range<2>{lsize, lsize}
+	};
+	samples::trace::submit(queue, {"lm_kernel", range, 2.0*gsize()*gsize()*sizeof(utx::fc32)},
 		[&] (sycl::handler & handler)
 		{
 			auto acc = buffer.get_access<sycl::access_mode::read_write>(handler);
 			auto lm = sycl::local_accessor<utx::fc32, 2>{sycl::range<2>{lsize*1, lsize*1}, handler};
 			handler.parallel_for<class lm_kernel>(
-				sycl::nd_range<2>{
-					sycl::range<2>{gsize, gsize},
-					sycl::range<2>{lsize, lsize}
-				},
+				range,
 				[=] (sycl::nd_item<2> item)
 				{
 					utx::uc32 gid0 = item.get_global_id(0);
@@ -0,0 +1,210 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// init -> sqrt -> sin -> gemm, recorded once as a samples::task_graph and replayed
+// (see task-graph.hpp), against the submit-and-destroy pattern of the other samples.
+//
+//	task-graph --gemm-size=512 --warmup=2 --repeat=50 --format=csv
+//
+//	pipeline-buffer-destroy  buffers built and destroyed every run, the host blocks in the destructors
+//	pipeline-usm-wait        usm, the host waits after every kernel
+//	graph-replay-wait        one replay, then wait
+//	graph-replay-submit      host time of replay() alone, replays queue up behind each other
+//	graph-replay-kernels     kernel time of one replay from event profiling
+//
+// The sizes are n x n with n = --gemm-size; gemm multiplies by the identity, so C = sin(sqrt(x)).
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include "bench.hpp"
+#include "gemm.hpp"
+#include "task-graph.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using data_type = utx::fc32;
+using tile_type = samples::gemm_tile<>;
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+
+	const std::size_t n = opts.gemm_size;
+	const std::size_t size = n*n;
+	const double flops = 2.0*n*n*n + 2.0*size;
+
+	std::vector<data_type> identity(size, 0.0f), result(size);
+	for (std::size_t i=0; i<n; i++)
+		identity[i*n+i] = 1.0f;
+
+	// submit and destroy, as in matrix-mul and three-dim-nd-lm
+	report(samples::bench::run_host(opts, "pipeline-buffer-destroy", "fc32", size, 0, flops,
+		[&]
+		{
+			sycl::buffer<data_type, 2> x{sycl::range<2>{n, n}}, y{sycl::range<2>{n, n}}, z{sycl::range<2>{n, n}};
+			sycl::buffer<data_type, 2> w{identity.data(), sycl::range<2>{n, n}};
+			sycl::buffer<data_type, 2> c{result.data(), sycl::range<2>{n, n}};
+			queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					auto acc = sycl::accessor{x, handler, sycl::write_only, sycl::no_init};
+					handler.parallel_for<class buffer_init>(
+						sycl::range<2>{n, n},
+						[=] (sycl::id<2> id)
+						{
+							acc[id] = static_cast<float>((id[0]*n+id[1])%1024)/1024.0f;
+						}
+					);
+				}
+			);
+			queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					auto in = sycl::accessor{x, handler, sycl::read_only};
+					auto out = sycl::accessor{y, handler, sycl::write_only, sycl::no_init};
+					handler.parallel_for<class buffer_sqrt>(
+						sycl::range<2>{n, n},
+						[=] (sycl::id<2> id)
+						{
+							out[id] = utx::sqrt(in[id]);
+						}
+					);
+				}
+			);
+			queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					auto in = sycl::accessor{y, handler, sycl::read_only};
+					auto out = sycl::accessor{z, handler, sycl::write_only, sycl::no_init};
+					handler.parallel_for<class buffer_sin>(
+						sycl::range<2>{n, n},
+						[=] (sycl::id<2> id)
+						{
+							out[id] = utx::sin(in[id]);
+						}
+					);
+				}
+			);
+			samples::gemm<data_type, tile_type>(queue, z, w, c);
+		}
+	));
+
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+	auto x = samples::make_pooled<data_type>(pool, size);
+	auto y = samples::make_pooled<data_type>(pool, size);
+	auto z = samples::make_pooled<data_type>(pool, size);
+	auto w = samples::make_pooled<data_type>(pool, size);
+	auto c = samples::make_pooled<data_type>(pool, size);
+	queue.memcpy(w.get(), identity.data(), size*sizeof(data_type)).wait();
+
+	data_type * px = x.get(), * py = y.get(), * pz = z.get(), * pc = c.get();
+	const data_type * pw = w.get();
+	const samples::task_graph::command init_cgf =
+		[=] (sycl::handler & handler)
+		{
+			handler.parallel_for<class graph_init>(
+				sycl::range<1>{size},
+				[=] (sycl::id<1> id)
+				{
+					px[id] = static_cast<float>(id[0]%1024)/1024.0f;
+				}
+			);
+		};
+	const samples::task_graph::command sqrt_cgf =
+		[=] (sycl::handler & handler)
+		{
+			handler.parallel_for<class graph_sqrt>(
+				sycl::range<1>{size},
+				[=] (sycl::id<1> id)
+				{
+					py[id] = utx::sqrt(px[id]);
+				}
+			);
+		};
+	const samples::task_graph::command sin_cgf =
+		[=] (sycl::handler & handler)
+		{
+			handler.parallel_for<class graph_sin>(
+				sycl::range<1>{size},
+				[=] (sycl::id<1> id)
+				{
+					pz[id] = utx::sin(py[id]);
+				}
+			);
+		};
+	samples::check_gemm_tile<tile_type, data_type>(queue.get_device());
+	const samples::task_graph::command gemm_cgf =
+		[=] (sycl::handler & handler)
+		{
+			samples::gemm_tiled<data_type, tile_type, true>(
+				handler,
+				samples::row_major<const data_type>{pz, n},
+				samples::row_major<const data_type>{pw, n},
+				samples::row_major<data_type>{pc, n},
+				n, n, n
+			);
+		};
+
+	report(samples::bench::run_host(opts, "pipeline-usm-wait", "fc32", size, 0, flops,
+		[&]
+		{
+			for (const auto & cgf: {init_cgf, sqrt_cgf, sin_cgf, gemm_cgf})
+				queue.submit(cgf).wait();
+		}
+	));
+
+	samples::task_graph graph;
+	const auto n_init = graph.add("init", init_cgf);
+	const auto n_sqrt = graph.add("sqrt", sqrt_cgf, {n_init});
+	const auto n_sin = graph.add("sin", sin_cgf, {n_sqrt});
+	graph.add("gemm", gemm_cgf, {n_sin});
+
+	auto replays = [&] (const std::string & suffix)
+	{
+		report(samples::bench::run_host(opts, "graph-replay-wait"+suffix, "fc32", size, 0, flops,
+			[&]
+			{
+				graph.replay(queue);
+				graph.wait();
+			}
+		));
+		report(samples::bench::run_host(opts, "graph-replay-submit"+suffix, "fc32", size, 0, flops,
+			[&]
+			{
+				graph.replay(queue);
+			}
+		));
+		graph.wait();
+	};
+	replays("");
+	report(samples::bench::run(opts, "graph-replay-kernels", "fc32", size, 0, flops,
+		[&]
+		{
+			graph.replay(queue);
+			return graph.node_events();
+		}
+	));
+	if (graph.finalize(queue))
+		replays("-native");
+
+	queue.memcpy(result.data(), pc, size*sizeof(data_type)).wait();
+	for (std::size_t i=0; i<size; i++)
+	{
+		const float want = std::sin(std::sqrt(static_cast<float>(i%1024)/1024.0f));
+		if (std::abs(result[i]() - want) > 1e-5f)
+		{
+			utx::printe("task-graph FAILED at", i, result[i], "!=", want);
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::task_graph: record a pipeline of command groups once, replay it many times.
+//
+//	samples::task_graph graph;
+//	auto init = graph.add("init", [=] (sycl::handler & handler) { ... });
+//	auto step = graph.add("sqrt", [=] (sycl::handler & handler) { ... }, {init});
+//	for (...)
+//		graph.replay(queue);
+//	graph.wait();
+//
+// Every node is a command group function and the list of nodes it depends on, so the
+// ordering is explicit and nothing waits on the host between nodes. Nodes are replayed in
+// the order they were added (a node only depends on earlier nodes); the sources of a
+// replay depend on the sinks of the previous replay, so replays never overlap on the same
+// memory. With the sycl_ext_oneapi_graph extension, finalize(queue) turns the recording
+// into one executable graph and every replay is a single submission.
+//
+// The command groups run again on every replay: they must capture usm pointers or
+// buffers that outlive the graph, never stack memory of the recording scope.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples
+{
+
+class task_graph
+{
+public:
+	using node = std::size_t;
+	using command = std::function<void (sycl::handler &)>;
+
+private:
+	struct entry
+	{
+		std::string name;
+		command cgf;
+		std::vector<node> deps;
+		bool sink = true; // no later node depends on it
+	};
+
+	std::vector<entry> nodes;
+	std::vector<sycl::event> events; // of every node in the last replay
+	std::vector<sycl::event> sinks; // of the last replay
+	std::vector<sycl::event> scratch;
+
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+	using executable_graph = sycl::ext::oneapi::experimental::command_graph<
+		sycl::ext::oneapi::experimental::graph_state::executable>;
+	std::optional<executable_graph> executable;
+#endif
+
+public:
+	node add(std::string name, command cgf, std::vector<node> deps = {})
+	{
+		for (node dep: deps)
+		{
+			if (dep >= nodes.size())
+				throw std::invalid_argument{"samples::task_graph: dependency on a later node"};
+			nodes[dep].sink = false;
+		}
+		nodes.push_back({std::move(name), std::move(cgf), std::move(deps)});
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+		executable.reset();
+#endif
+		return nodes.size()-1;
+	}
+
+	std::size_t size() const
+	{
+		return nodes.size();
+	}
+
+	const std::string & name(node id) const
+	{
+		return nodes.at(id).name;
+	}
+
+	// Builds a native executable graph when the sycl implementation has one.
+	// Returns false when replay keeps submitting node by node.
+	bool finalize([[maybe_unused]] sycl::queue & queue)
+	{
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+		namespace exp = sycl::ext::oneapi::experimental;
+		exp::command_graph graph{queue.get_context(), queue.get_device(),
+			{exp::property::graph::assume_buffer_outlives_graph{}}};
+		std::vector<exp::node> handles;
+		handles.reserve(nodes.size());
+		for (const entry & e: nodes)
+		{
+			handles.push_back(graph.add(e.cgf));
+			for (node dep: e.deps)
+				graph.make_edge(handles[dep], handles.back());
+		}
+		executable.emplace(graph.finalize());
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool native() const
+	{
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+		return executable.has_value();
+#else
+		return false;
+#endif
+	}
+
+	// Submits the whole graph once, after deps and the previous replay, and returns
+	// the events of its sinks. The host does not wait.
+	const std::vector<sycl::event> & replay(sycl::queue & queue, const std::vector<sycl::event> & deps = {})
+	{
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+		if (executable)
+		{
+			scratch.assign(sinks.begin(), sinks.end());
+			scratch.insert(scratch.end(), deps.begin(), deps.end());
+			sinks.assign(1, queue.ext_oneapi_graph(*executable, scratch));
+			return sinks;
+		}
+#endif
+		events.resize(nodes.size());
+		for (std::size_t i=0; i<nodes.size(); i++)
+		{
+			const entry & e = nodes[i];
+			scratch.clear();
+			for (node dep: e.deps)
+				scratch.push_back(events[dep]);
+			if (e.deps.empty())
+			{
+				scratch.insert(scratch.end(), sinks.begin(), sinks.end());
+				scratch.insert(scratch.end(), deps.begin(), deps.end());
+			}
+			events[i] = queue.submit(
+				[&] (sycl::handler & handler)
+				{
+					handler.depends_on(scratch);
+					e.cgf(handler);
+				}
+			);
+		}
+		sinks.clear();
+		for (std::size_t i=0; i<nodes.size(); i++)
+			if (nodes[i].sink)
+				sinks.push_back(events[i]);
+		return sinks;
+	}
+
+	// events of every node in the last replay, in node order (node by node replays only)
+	const std::vector<sycl::event> & node_events() const
+	{
+		return events;
+	}
+
+	void wait()
+	{
+		sycl::event::wait(sinks);
+	}
+};
+
+} // namespace samples
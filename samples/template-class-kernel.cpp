@@ -9,6 +9,7 @@
 #include <utxcpp/core.hpp>
 #include <utxcpp/algorithm.hpp>
 #include <utxcpp/math.hpp>
+#include "launch.hpp"
 
 template <typename data_type>
 class utx_cbrt_kernel_class
@@ -22,13 +23,14 @@ public:
 		acc{acc}
 	{
 	}
-	void operator()(sycl::nd_item<1> item) const
+	void operator()(sycl::id<1> id) const
 	{
-		utx::uc32 gid = item.get_global_id(0);
-		acc[gid()] = utx::cbrt(acc[gid()]);
+		acc[id] = utx::cbrt(acc[id]);
 	}
 };
 
+class utx_cbrt_kernel;
+
 int main()
 {
 	sycl::queue queue;
@@ -42,18 +44,17 @@ int main()
 		return 1;
 	}
 
-	std::vector<utx::fc32> vector(8);
+	std::vector<utx::fc32> vector(9); // any size: the launch is padded to whole work-groups
 	utx::iota(vector, 1);
 	auto buff = new sycl::buffer<utx::fc32, 1>{vector};
 
+	const auto extent = sycl::range<1>{vector.size()};
+	const auto local = samples::launch::local_range(queue.get_device(), extent);
 	queue.submit(
 		[&] (sycl::handler & handler)
 		{
 			auto acc = buff->get_access<sycl::access_mode::read_write>(handler);
-			handler.parallel_for<class utx_cbrt_kernel>(
-				sycl::nd_range<1>{sycl::range<1>{vector.size()}, sycl::range<1>{vector.size()%2==0?2u:1u}},
-				utx_cbrt_kernel_class{acc}
-			);
+			samples::launch::masked<utx_cbrt_kernel>(handler, extent, local, utx_cbrt_kernel_class{acc});
 		}
 	);
 
@@ -0,0 +1,368 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::tensor_file: a self-describing binary tensor file, read and written through mmap.
+//
+//	offset  0   char[4]   magic "UTXT"
+//	        4   u32       version (1)
+//	        8   u32       dtype
+//	       12   u32       rank
+//	       16   u64[rank] extents, outermost first (row-major)
+//	            ...       zeros up to data_alignment
+//	 data_offset          the elements, native byte order
+//
+// samples::tensor_file::mapped maps the whole file MAP_SHARED, so
+//
+//	sycl::buffer<T, dims>{ptr, range, {sycl::property::buffer::use_host_ptr{}}}
+//
+// over data() hands the mapped pages to the runtime without a staging copy, and a
+// writable buffer writes its results back into the file when it is destroyed.
+// USM kernels read data() directly on devices with aspect::usm_system_allocations;
+// elsewhere the copies of samples::streaming move it in blocks.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace samples::tensor_file
+{
+
+enum class dtype: std::uint32_t
+{
+	i8 = 1,
+	u8 = 2,
+	i32 = 3,
+	u32 = 4,
+	f32 = 5,
+	f64 = 6,
+};
+
+inline std::size_t dtype_size(dtype type)
+{
+	switch (type)
+	{
+	case dtype::i8:
+	case dtype::u8:
+		return 1;
+	case dtype::i32:
+	case dtype::u32:
+	case dtype::f32:
+		return 4;
+	case dtype::f64:
+		return 8;
+	}
+	throw std::invalid_argument{"samples::tensor_file: unknown dtype"};
+}
+
+// dtype of a utx class type or of a fundamental type
+template <typename data_type>
+constexpr dtype dtype_of()
+{
+	using raw_type = raw_value_t<data_type>;
+	static_assert(sizeof(raw_type) == sizeof(data_type));
+	if constexpr (std::is_same_v<raw_type, std::int8_t>)
+		return dtype::i8;
+	else if constexpr (std::is_same_v<raw_type, std::uint8_t>)
+		return dtype::u8;
+	else if constexpr (std::is_same_v<raw_type, std::int32_t>)
+		return dtype::i32;
+	else if constexpr (std::is_same_v<raw_type, std::uint32_t>)
+		return dtype::u32;
+	else if constexpr (std::is_same_v<raw_type, float>)
+		return dtype::f32;
+	else if constexpr (std::is_same_v<raw_type, double>)
+		return dtype::f64;
+	else
+		static_assert(sizeof(data_type) == 0, "samples::tensor_file: no dtype for this type");
+}
+
+constexpr char magic[4] = {'U', 'T', 'X', 'T'};
+constexpr std::uint32_t version = 1;
+// page aligned data, so use_host_ptr buffers may be used in place
+constexpr std::size_t data_alignment = 4096;
+
+struct header
+{
+	dtype type;
+	std::vector<std::size_t> extents;
+
+	std::size_t count() const
+	{
+		return std::accumulate(extents.begin(), extents.end(), std::size_t{1}, std::multiplies<>{});
+	}
+	std::size_t data_offset() const
+	{
+		return round_up(16 + 8*extents.size(), data_alignment);
+	}
+	std::size_t file_size() const
+	{
+		return data_offset() + count()*dtype_size(type);
+	}
+	// file_size() in total, false when it does not fit in std::size_t
+	bool checked_file_size(std::size_t & total) const
+	{
+		std::size_t bytes = dtype_size(type);
+		for (std::size_t extent: extents)
+			if (__builtin_mul_overflow(bytes, extent, &bytes))
+				return false;
+		return ! __builtin_add_overflow(data_offset(), bytes, &total);
+	}
+};
+
+class mapped
+{
+private:
+	int fd = -1;
+	void * base = nullptr;
+	std::size_t size = 0;
+	bool writable = false;
+	tensor_file::header info;
+
+	void close()
+	{
+		if (base)
+			::munmap(base, size);
+		if (fd >= 0)
+			::close(fd);
+		base = nullptr;
+		fd = -1;
+	}
+
+	// closes what is open and throws the current errno
+	[[noreturn]] void fail(const std::string & what, const std::string & path)
+	{
+		const int error = errno;
+		close();
+		throw std::system_error{error, std::generic_category(), "samples::tensor_file: " + what + " " + path};
+	}
+
+	[[noreturn]] void invalid(const std::string & what, const std::string & path)
+	{
+		close();
+		throw std::runtime_error{"samples::tensor_file: " + what + " " + path};
+	}
+
+	void map(const std::string & path)
+	{
+		const int prot = writable ? PROT_READ|PROT_WRITE : PROT_READ;
+		base = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED)
+		{
+			base = nullptr;
+			fail("cannot map", path);
+		}
+	}
+
+	mapped() = default;
+
+public:
+	enum class mode
+	{
+		read_only,
+		read_write,
+	};
+
+	// Maps an existing tensor file.
+	explicit mapped(const std::string & path, mode access = mode::read_only):
+		writable{access == mode::read_write}
+	{
+		fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+		if (fd < 0)
+			fail("cannot open", path);
+		struct stat st;
+		if (::fstat(fd, &st) != 0)
+			fail("cannot stat", path);
+		size = st.st_size;
+		if (size < 16)
+			invalid("not a tensor file", path);
+		map(path);
+
+		const auto * bytes = static_cast<const unsigned char *>(base);
+		std::uint32_t fields[3];
+		std::memcpy(fields, bytes+4, sizeof(fields));
+		const std::size_t rank = fields[2];
+		if (std::memcmp(bytes, magic, 4) != 0 || fields[0] != version ||
+			fields[1] < static_cast<std::uint32_t>(dtype::i8) || fields[1] > static_cast<std::uint32_t>(dtype::f64) ||
+			16 + 8*rank > size)
+			invalid("not a tensor file", path);
+		info.type = static_cast<dtype>(fields[1]);
+		for (std::size_t r=0; r<rank; r++)
+		{
+			std::uint64_t extent;
+			std::memcpy(&extent, bytes + 16 + 8*r, sizeof(extent));
+			info.extents.push_back(extent);
+		}
+		std::size_t total;
+		if (! info.checked_file_size(total))
+			invalid("extents overflow in tensor file", path);
+		if (total > size)
+			invalid("truncated tensor file", path);
+		::madvise(base, size, MADV_SEQUENTIAL);
+	}
+
+	// Creates (or replaces) a tensor file of type and extents, mapped read-write.
+	// The elements are zero until they are written.
+	static mapped create(const std::string & path, dtype type, const std::vector<std::size_t> & extents)
+	{
+		mapped file;
+		file.writable = true;
+		file.info = {type, extents};
+		if (! file.info.checked_file_size(file.size))
+			throw std::invalid_argument{"samples::tensor_file: extents overflow"};
+		file.fd = ::open(path.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+		if (file.fd < 0)
+			file.fail("cannot create", path);
+		if (::ftruncate(file.fd, file.size) != 0)
+			file.fail("cannot resize", path);
+		file.map(path);
+
+		auto * bytes = static_cast<unsigned char *>(file.base);
+		const std::uint32_t fields[3] = {version, static_cast<std::uint32_t>(type), static_cast<std::uint32_t>(extents.size())};
+		std::memcpy(bytes, magic, 4);
+		std::memcpy(bytes+4, fields, sizeof(fields));
+		for (std::size_t r=0; r<extents.size(); r++)
+		{
+			const std::uint64_t extent = extents[r];
+			std::memcpy(bytes + 16 + 8*r, &extent, sizeof(extent));
+		}
+		return file;
+	}
+
+	mapped(const mapped &) = delete;
+	mapped & operator=(const mapped &) = delete;
+	mapped(mapped && other) noexcept:
+		fd{std::exchange(other.fd, -1)},
+		base{std::exchange(other.base, nullptr)},
+		size{std::exchange(other.size, 0)},
+		writable{other.writable},
+		info{std::move(other.info)}
+	{
+	}
+	mapped & operator=(mapped && other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			fd = std::exchange(other.fd, -1);
+			base = std::exchange(other.base, nullptr);
+			size = std::exchange(other.size, 0);
+			writable = other.writable;
+			info = std::move(other.info);
+		}
+		return *this;
+	}
+	~mapped()
+	{
+		close();
+	}
+
+	const tensor_file::header & header() const
+	{
+		return info;
+	}
+	dtype type() const
+	{
+		return info.type;
+	}
+	std::size_t rank() const
+	{
+		return info.extents.size();
+	}
+	const std::vector<std::size_t> & extents() const
+	{
+		return info.extents;
+	}
+	std::size_t count() const
+	{
+		return info.count();
+	}
+
+	template <typename data_type>
+	data_type * data()
+	{
+		check<data_type>();
+		if (! writable)
+			throw std::logic_error{"samples::tensor_file: file is mapped read only"};
+		return reinterpret_cast<data_type *>(static_cast<unsigned char *>(base) + info.data_offset());
+	}
+
+	template <typename data_type>
+	const data_type * data() const
+	{
+		check<data_type>();
+		return reinterpret_cast<const data_type *>(static_cast<const unsigned char *>(base) + info.data_offset());
+	}
+
+	template <int dims>
+	sycl::range<dims> range() const
+	{
+		if (rank() != dims)
+			throw std::invalid_argument{"samples::tensor_file: rank does not match"};
+		std::array<std::size_t, dims> values;
+		std::copy(info.extents.begin(), info.extents.end(), values.begin());
+		return to_range<dims>(values);
+	}
+
+	// Flushes the written pages to the file. A failure throws and leaves the mapping open.
+	void sync()
+	{
+		if (base && writable && ::msync(base, size, MS_SYNC) != 0)
+			throw std::system_error{errno, std::generic_category(), "samples::tensor_file: cannot sync"};
+	}
+
+private:
+	template <typename data_type>
+	void check() const
+	{
+		if (dtype_of<data_type>() != info.type)
+			throw std::invalid_argument{"samples::tensor_file: dtype does not match"};
+	}
+};
+
+// A buffer over the mapped elements. Kernels read the file in place; nothing is written back.
+template <typename data_type, int dims>
+sycl::buffer<data_type, dims> input_buffer(const mapped & file)
+{
+	return sycl::buffer<data_type, dims>{file.data<data_type>(), file.range<dims>(),
+		{sycl::property::buffer::use_host_ptr{}}};
+}
+
+// A buffer over the mapped elements that writes its contents back into the file
+// when the last copy of the buffer is destroyed.
+template <typename data_type, int dims>
+sycl::buffer<data_type, dims> output_buffer(mapped & file)
+{
+	return sycl::buffer<data_type, dims>{file.data<data_type>(), file.range<dims>(),
+		{sycl::property::buffer::use_host_ptr{}}};
+}
+
+// true when usm kernels on device can dereference data() of a mapped file
+inline bool usm_in_place(const sycl::device & device)
+{
+	return device.has(sycl::aspect::usm_system_allocations);
+}
+
+} // namespace samples::tensor_file
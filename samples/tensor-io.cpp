@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::gemm and utx::sqrt on memory-mapped tensor files (see tensor-file.hpp).
+//
+//	tensor-io                    : write a.utxt and b.utxt (512 x 512 fc32) to the temp directory first.
+//	tensor-io A B C [SQRT]       : C = A x B for the rank 2 fc32 files A and B, then SQRT = sqrt(C).
+//
+// A and B reach the kernel through use_host_ptr buffers over the mapping, and C is written
+// back into its file by the buffer destructor, with no staging copy on the host.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include "gemm.hpp"
+#include "streaming.hpp"
+#include "tensor-file.hpp"
+#include "usm-pool.hpp"
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace tensor_file = samples::tensor_file;
+
+struct sqrt_op
+{
+	utx::fc32 operator()(utx::fc32 x) const
+	{
+		return utx::sqrt(x);
+	}
+};
+
+void write_matrix(const std::string & path, std::size_t rows, std::size_t cols, std::size_t seed)
+{
+	auto file = tensor_file::mapped::create(path, tensor_file::dtype_of<utx::fc32>(), {rows, cols});
+	utx::fc32 * data = file.data<utx::fc32>();
+	for (std::size_t i=0; i<rows*cols; i++)
+		data[i] = static_cast<float>((i*seed)%17)/16.0f;
+	file.sync();
+}
+
+// A header whose extents wrap the byte count of the elements to less than one page
+// must be rejected instead of mapped.
+bool rejects_overflowing_extents(const std::string & path)
+{
+	{
+		std::ofstream out{path, std::ios::binary|std::ios::trunc};
+		const std::uint32_t fields[3] = {tensor_file::version, static_cast<std::uint32_t>(tensor_file::dtype::f32), 2};
+		const std::uint64_t extents[2] = {(std::uint64_t{1} << 32) + 1, (std::uint64_t{1} << 32) - 1};
+		out.write(tensor_file::magic, 4);
+		out.write(reinterpret_cast<const char *>(fields), sizeof(fields));
+		out.write(reinterpret_cast<const char *>(extents), sizeof(extents));
+		const std::string padding(tensor_file::data_alignment, '\0');
+		out.write(padding.data(), padding.size());
+	}
+	try
+	{
+		const tensor_file::mapped file{path};
+		utx::printe("malformed header FAILED: mapped", file.count(), "elements");
+		return false;
+	}
+	catch (const std::runtime_error &)
+	{
+		return true;
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	const auto tmp = std::filesystem::temp_directory_path();
+	std::string path_a = (tmp/"a.utxt").string();
+	std::string path_b = (tmp/"b.utxt").string();
+	std::string path_c = (tmp/"c.utxt").string();
+	std::string path_sqrt = (tmp/"c-sqrt.utxt").string();
+	if (argc >= 4)
+	{
+		path_a = argv[1];
+		path_b = argv[2];
+		path_c = argv[3];
+		path_sqrt = argc >= 5 ? argv[4] : path_c + ".sqrt";
+	}
+	else
+	{
+		write_matrix(path_a, 512, 512, 7);
+		write_matrix(path_b, 512, 512, 5);
+	}
+
+	sycl::queue queue;
+	utx::print("Running on device:", queue.get_device().get_info<sycl::info::device::name>());
+
+	bool ok = rejects_overflowing_extents((tmp/"malformed.utxt").string());
+	utx::print("malformed header:", ok ? "rejected" : "FAILED");
+
+	const tensor_file::mapped a{path_a}, b{path_b};
+	const std::size_t m = a.extents().at(0), k = a.extents().at(1), n = b.extents().at(1);
+	utx::print("A:", m, "x", k, "B:", b.extents().at(0), "x", n);
+	tensor_file::mapped c = tensor_file::mapped::create(path_c, tensor_file::dtype_of<utx::fc32>(), {m, n});
+
+	{
+		auto buf_a = tensor_file::input_buffer<utx::fc32, 2>(a);
+		auto buf_b = tensor_file::input_buffer<utx::fc32, 2>(b);
+		auto buf_c = tensor_file::output_buffer<utx::fc32, 2>(c);
+		samples::gemm(queue, buf_a, buf_b, buf_c);
+	} // buf_c writes back into the mapping here
+	c.sync();
+
+	// a few rows against the host
+	const utx::fc32 * pa = a.data<utx::fc32>();
+	const utx::fc32 * pb = b.data<utx::fc32>();
+	const utx::fc32 * pc = std::as_const(c).data<utx::fc32>();
+	bool gemm_ok = true;
+	for (std::size_t i=0; i<m && gemm_ok; i+=m/7+1)
+		for (std::size_t j=0; j<n; j++)
+		{
+			double want = 0;
+			for (std::size_t p=0; p<k; p++)
+				want += pa[i*k+p]() * pb[p*n+j]();
+			if (std::abs(pc[i*n+j]() - want) > 1e-5*k*(1+std::abs(want)))
+			{
+				utx::printe("gemm FAILED at", i, j, pc[i*n+j], "!=", want);
+				gemm_ok = false;
+				break;
+			}
+		}
+	utx::print("gemm:", path_c, gemm_ok ? "ok" : "FAILED");
+	ok = gemm_ok && ok;
+
+	// sqrt(C) into another file, through usm
+	tensor_file::mapped s = tensor_file::mapped::create(path_sqrt, c.type(), c.extents());
+	const std::size_t size = c.count();
+	utx::fc32 * ps = s.data<utx::fc32>();
+	if (tensor_file::usm_in_place(queue.get_device()))
+	{
+		utx::print("sqrt: usm kernel on the mapping");
+		queue.parallel_for<class sqrt_mapped>(
+			sycl::range<1>{size},
+			[=] (sycl::id<1> id)
+			{
+				ps[id] = utx::sqrt(pc[id]);
+			}
+		).wait();
+	}
+	else
+	{
+		utx::print("sqrt: streamed through device memory");
+		samples::usm_pool pool{queue, sycl::usm::alloc::device};
+		samples::streaming::transform(queue, pool, pc, ps, size, sqrt_op{});
+	}
+	s.sync();
+	for (std::size_t i=0; i<size; i+=size/97+1)
+		if (std::abs(ps[i]() - std::sqrt(pc[i]())) > 1e-5f*(1+ps[i]()))
+		{
+			utx::printe("sqrt FAILED at", i);
+			ok = false;
+			break;
+		}
+	utx::print("sqrt:", path_sqrt, ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
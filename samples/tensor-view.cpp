@@ -0,0 +1,244 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// One 2d stencil, 3d stencil and transpose kernel each, run on every tensor view layout
+// (see tensor-view.hpp).
+//
+//	tensor-view --size=16777216 --warmup=2 --repeat=10 --format=csv
+//
+// The 2d grids are n x n and the 3d grids m x m x m, with n*n and m*m*m close to --size.
+// The kernels only see samples::tensor::view; the layout is their template argument.
+// Work-items are launched row-major, so layout_left is the strided case.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "tensor-view.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace tensor = samples::tensor;
+
+template <typename layout_type, int dims>
+class init_kernel;
+
+template <typename layout_type>
+class stencil_2d_kernel;
+
+template <typename layout_type>
+class stencil_3d_kernel;
+
+template <typename layout_type>
+class view_transpose_kernel;
+
+template <int dims>
+float pattern(const sycl::id<dims> & id)
+{
+	std::size_t s = 0;
+	for (int d=0; d<dims; d++)
+		s = s*31 + id[d];
+	return static_cast<float>(s%17)*0.25f;
+}
+
+// 5-point average inside, copy on the boundary
+template <typename view_type>
+utx::fc32 stencil_2d(const view_type & in, std::size_t i, std::size_t j)
+{
+	if (i == 0 || j == 0 || i+1 == in.extent(0) || j+1 == in.extent(1))
+		return in(i, j);
+	return 0.5f*in(i, j)() + 0.125f*(in(i-1, j)() + in(i+1, j)() + in(i, j-1)() + in(i, j+1)());
+}
+
+// 7-point average inside, copy on the boundary
+template <typename view_type>
+utx::fc32 stencil_3d(const view_type & in, std::size_t i, std::size_t j, std::size_t k)
+{
+	if (i == 0 || j == 0 || k == 0 || i+1 == in.extent(0) || j+1 == in.extent(1) || k+1 == in.extent(2))
+		return in(i, j, k);
+	return 0.4f*in(i, j, k)() + 0.1f*(in(i-1, j, k)() + in(i+1, j, k)() + in(i, j-1, k)() + in(i, j+1, k)() +
+		in(i, j, k-1)() + in(i, j, k+1)());
+}
+
+class runner
+{
+private:
+	sycl::queue & queue;
+	const samples::bench::options & opts;
+	samples::bench::reporter & report;
+	samples::usm_pool & pool;
+	sycl::range<2> extents_2d;
+	sycl::range<3> extents_3d;
+
+	// the host values of a device view in its layout
+	template <typename layout_type, int dims>
+	std::vector<utx::fc32> download(const tensor::view<utx::fc32, dims, layout_type> & v)
+	{
+		std::vector<utx::fc32> host(v.required_size(v.extents()));
+		queue.memcpy(host.data(), v.data(), host.size()*sizeof(utx::fc32)).wait();
+		return host;
+	}
+
+	template <typename layout_type, int dims>
+	void init(const tensor::view<utx::fc32, dims, layout_type> & v)
+	{
+		queue.parallel_for<init_kernel<layout_type, dims>>(
+			v.extents(),
+			[=] (sycl::id<dims> id)
+			{
+				v[id] = pattern(id);
+			}
+		).wait();
+	}
+
+	// every element of out against want(id)
+	template <typename layout_type, int dims, typename want_type>
+	bool check(const std::string & label, const tensor::view<utx::fc32, dims, layout_type> & out, want_type want)
+	{
+		auto host = download(out);
+		const tensor::view<utx::fc32, dims, layout_type> result{host.data(), out.extents()};
+		for (std::size_t i=0; i<out.size(); i++)
+		{
+			sycl::id<dims> id;
+			std::size_t rest = i;
+			for (int d=dims-1; d>=0; d--)
+			{
+				id[d] = rest%out.extent(d);
+				rest /= out.extent(d);
+			}
+			const float expected = want(id);
+			if (std::abs(result[id]() - expected) > 1e-5f*(1+std::abs(expected)))
+			{
+				utx::printe(label, "FAILED at", i, result[id], "!=", expected);
+				return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	runner(sycl::queue & queue, const samples::bench::options & opts, samples::bench::reporter & report,
+		samples::usm_pool & pool, std::size_t side_2d, std::size_t side_3d):
+		queue{queue},
+		opts{opts},
+		report{report},
+		pool{pool},
+		extents_2d{side_2d, side_2d},
+		extents_3d{side_3d, side_3d, side_3d}
+	{
+	}
+
+	template <typename layout_type>
+	bool layout(const std::string & name)
+	{
+		using view_2d = tensor::view<utx::fc32, 2, layout_type>;
+		using view_3d = tensor::view<utx::fc32, 3, layout_type>;
+		bool ok = true;
+
+		auto a = samples::make_pooled<utx::fc32>(pool, view_2d::required_size(extents_2d));
+		auto b = samples::make_pooled<utx::fc32>(pool, view_2d::required_size(extents_2d));
+		const view_2d in_2d{a.get(), extents_2d}, out_2d{b.get(), extents_2d};
+		init(in_2d);
+		const std::size_t size_2d = extents_2d.size();
+		const double bytes_2d = 2.0*size_2d*sizeof(utx::fc32);
+
+		report(samples::bench::run(opts, "stencil-2d-" + name, "fc32", size_2d, bytes_2d, 6.0*size_2d,
+			[&]
+			{
+				return queue.parallel_for<stencil_2d_kernel<layout_type>>(
+					extents_2d,
+					[=] (sycl::id<2> id)
+					{
+						out_2d[id] = stencil_2d(in_2d, id[0], id[1]);
+					}
+				);
+			}
+		));
+		std::vector<utx::fc32> host_2d(size_2d);
+		for (std::size_t i=0; i<size_2d; i++)
+			host_2d[i] = pattern(sycl::id<2>{i/extents_2d[1], i%extents_2d[1]});
+		const tensor::view<utx::fc32, 2> reference_2d{host_2d.data(), extents_2d};
+		ok = check("stencil-2d-" + name, out_2d,
+			[&] (const sycl::id<2> & id)
+			{
+				return stencil_2d(reference_2d, id[0], id[1])();
+			}
+		) && ok;
+
+		report(samples::bench::run(opts, "transpose-" + name, "fc32", size_2d, bytes_2d, 0,
+			[&]
+			{
+				return queue.parallel_for<view_transpose_kernel<layout_type>>(
+					extents_2d,
+					[=] (sycl::id<2> id)
+					{
+						out_2d(id[1], id[0]) = in_2d[id];
+					}
+				);
+			}
+		));
+		ok = check("transpose-" + name, out_2d,
+			[&] (const sycl::id<2> & id)
+			{
+				return pattern(sycl::id<2>{id[1], id[0]});
+			}
+		) && ok;
+
+		auto c = samples::make_pooled<utx::fc32>(pool, view_3d::required_size(extents_3d));
+		auto d = samples::make_pooled<utx::fc32>(pool, view_3d::required_size(extents_3d));
+		const view_3d in_3d{c.get(), extents_3d}, out_3d{d.get(), extents_3d};
+		init(in_3d);
+		const std::size_t size_3d = extents_3d.size();
+		report(samples::bench::run(opts, "stencil-3d-" + name, "fc32", size_3d, 2.0*size_3d*sizeof(utx::fc32),
+			8.0*size_3d,
+			[&]
+			{
+				return queue.parallel_for<stencil_3d_kernel<layout_type>>(
+					extents_3d,
+					[=] (sycl::id<3> id)
+					{
+						out_3d[id] = stencil_3d(in_3d, id[0], id[1], id[2]);
+					}
+				);
+			}
+		));
+		std::vector<utx::fc32> host_3d(size_3d);
+		const tensor::view<utx::fc32, 3> reference_3d{host_3d.data(), extents_3d};
+		for (std::size_t i=0; i<extents_3d[0]; i++)
+			for (std::size_t j=0; j<extents_3d[1]; j++)
+				for (std::size_t k=0; k<extents_3d[2]; k++)
+					reference_3d(i, j, k) = pattern(sycl::id<3>{i, j, k});
+		ok = check("stencil-3d-" + name, out_3d,
+			[&] (const sycl::id<3> & id)
+			{
+				return stencil_3d(reference_3d, id[0], id[1], id[2])();
+			}
+		) && ok;
+		return ok;
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t side_2d = std::max<std::size_t>(std::lround(std::sqrt(static_cast<double>(opts.size))), 3);
+	const std::size_t side_3d = std::max<std::size_t>(std::lround(std::cbrt(static_cast<double>(opts.size))), 3);
+	runner run{queue, opts, report, pool, side_2d, side_3d};
+
+	bool ok = run.layout<tensor::layout_right>("row-major");
+	ok = run.layout<tensor::layout_left>("column-major") && ok;
+	ok = run.layout<tensor::layout_tiled<8>>("tiled-8") && ok;
+	ok = run.layout<tensor::layout_tiled<32>>("tiled-32") && ok;
+	ok = run.layout<tensor::layout_morton>("morton") && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::tensor::view: an mdspan-like n-dimensional view with pluggable layouts.
+//
+//	samples::tensor::view<utx::fc32, 3> grid{ptr, sycl::range<3>{d0, d1, d2}};        // row-major
+//	samples::tensor::view<utx::fc32, 2, samples::tensor::layout_morton> m{ptr, {n, n}};
+//	grid(k, j, i) = m(j, i);                                                          // or grid[id]
+//
+// A view is a pointer and a mapping from indices to an offset, so it is device copyable
+// and costs what the index arithmetic costs. The layout policies:
+//	layout_right        row-major, the last index is contiguous (mdspan's layout_right)
+//	layout_left         column-major, the first index is contiguous
+//	layout_tiled<t>     t x t (x t) tiles in row-major tile order, row-major inside a tile;
+//	                    the extents are padded up to whole tiles
+//	layout_morton       Z-order: the bits of the indices interleaved, the last index in the
+//	                    lowest bit; the extents are padded to one power of two side
+// A kernel written against view<T, dims, layout> changes its memory layout when only the
+// layout argument changes. required_size gives the elements to allocate, which is more than
+// the extents for the padded layouts. On a buffer, make the view inside the kernel from the
+// accessor of a 1d buffer of required_size elements (see view_of).
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace samples::tensor
+{
+
+struct layout_right
+{
+	template <int dims>
+	struct mapping
+	{
+		sycl::range<dims> extents;
+
+		std::size_t required_size() const
+		{
+			return extents.size();
+		}
+		std::size_t operator()(const sycl::id<dims> & index) const
+		{
+			std::size_t offset = 0;
+			for (int d=0; d<dims; d++)
+				offset = offset*extents[d] + index[d];
+			return offset;
+		}
+	};
+};
+
+struct layout_left
+{
+	template <int dims>
+	struct mapping
+	{
+		sycl::range<dims> extents;
+
+		std::size_t required_size() const
+		{
+			return extents.size();
+		}
+		std::size_t operator()(const sycl::id<dims> & index) const
+		{
+			std::size_t offset = 0;
+			for (int d=dims-1; d>=0; d--)
+				offset = offset*extents[d] + index[d];
+			return offset;
+		}
+	};
+};
+
+template <std::size_t tile>
+struct layout_tiled
+{
+	static_assert(tile > 0);
+
+	template <int dims>
+	struct mapping
+	{
+		sycl::range<dims> extents;
+
+		std::size_t required_size() const
+		{
+			std::size_t size = 1;
+			for (int d=0; d<dims; d++)
+				size *= round_up(extents[d], tile);
+			return size;
+		}
+		std::size_t operator()(const sycl::id<dims> & index) const
+		{
+			std::size_t outer = 0, inner = 0;
+			for (int d=0; d<dims; d++)
+			{
+				outer = outer*((extents[d]+tile-1)/tile) + index[d]/tile;
+				inner = inner*tile + index[d]%tile;
+			}
+			std::size_t tile_size = 1;
+			for (int d=0; d<dims; d++)
+				tile_size *= tile;
+			return outer*tile_size + inner;
+		}
+	};
+};
+
+struct layout_morton
+{
+	// the bits of x at every second position
+	static std::uint64_t spread2(std::uint64_t x)
+	{
+		x &= 0xFFFFFFFF;
+		x = (x | x << 16) & 0x0000FFFF0000FFFF;
+		x = (x | x << 8) & 0x00FF00FF00FF00FF;
+		x = (x | x << 4) & 0x0F0F0F0F0F0F0F0F;
+		x = (x | x << 2) & 0x3333333333333333;
+		return (x | x << 1) & 0x5555555555555555;
+	}
+
+	// the low 21 bits of x at every third position
+	static std::uint64_t spread3(std::uint64_t x)
+	{
+		x &= 0x1FFFFF;
+		x = (x | x << 32) & 0x001F00000000FFFF;
+		x = (x | x << 16) & 0x001F0000FF0000FF;
+		x = (x | x << 8) & 0x100F00F00F00F00F;
+		x = (x | x << 4) & 0x10C30C30C30C30C3;
+		return (x | x << 2) & 0x1249249249249249;
+	}
+
+	template <int dims>
+	struct mapping
+	{
+		static_assert(dims >= 1 && dims <= 3);
+		sycl::range<dims> extents;
+
+		// the power of two side that holds every extent
+		std::size_t side() const
+		{
+			std::size_t largest = 1;
+			for (int d=0; d<dims; d++)
+				largest = std::max<std::size_t>(largest, extents[d]);
+			std::size_t s = 1;
+			while (s < largest)
+				s *= 2;
+			return s;
+		}
+		std::size_t required_size() const
+		{
+			std::size_t size = 1;
+			for (int d=0; d<dims; d++)
+				size *= side();
+			return size;
+		}
+		std::size_t operator()(const sycl::id<dims> & index) const
+		{
+			if constexpr (dims == 1)
+				return index[0];
+			else if constexpr (dims == 2)
+				return spread2(index[1]) | spread2(index[0]) << 1;
+			else
+				return spread3(index[2]) | spread3(index[1]) << 1 | spread3(index[0]) << 2;
+		}
+	};
+};
+
+template <typename data_type, int dims, typename layout_type = layout_right>
+class view
+{
+public:
+	using element_type = data_type;
+	using layout = layout_type;
+	using mapping_type = typename layout_type::template mapping<dims>;
+	static constexpr int rank = dims;
+
+private:
+	data_type * ptr;
+	mapping_type map;
+
+public:
+	view(data_type * ptr, const sycl::range<dims> & extents):
+		ptr{ptr},
+		map{extents}
+	{
+	}
+
+	// elements to allocate for extents in this layout
+	static std::size_t required_size(const sycl::range<dims> & extents)
+	{
+		return mapping_type{extents}.required_size();
+	}
+
+	data_type & operator[](const sycl::id<dims> & index) const
+	{
+		return ptr[map(index)];
+	}
+
+	template <typename ... index_types>
+		requires (sizeof...(index_types) == dims)
+	data_type & operator()(index_types ... index) const
+	{
+		return ptr[map(sycl::id<dims>{static_cast<std::size_t>(to_raw(index))...})];
+	}
+
+	sycl::range<dims> extents() const
+	{
+		return map.extents;
+	}
+	std::size_t extent(int d) const
+	{
+		return map.extents[d];
+	}
+	std::size_t size() const
+	{
+		return map.extents.size();
+	}
+	const mapping_type & mapping() const
+	{
+		return map;
+	}
+	data_type * data() const
+	{
+		return ptr;
+	}
+};
+
+// A view over the accessor of a 1d buffer of view::required_size elements; call it inside the kernel.
+template <typename layout_type = layout_right, int dims, typename accessor_type>
+auto view_of(const accessor_type & acc, const sycl::range<dims> & extents)
+{
+	using data_type = std::remove_reference_t<decltype(*acc.template get_multi_ptr<sycl::access::decorated::no>().get())>;
+	return view<data_type, dims, layout_type>{acc.template get_multi_ptr<sycl::access::decorated::no>().get(), extents};
+}
+
+} // namespace samples::tensor
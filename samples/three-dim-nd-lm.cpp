@@ -13,10 +13,13 @@
 #include <utxcpp/algorithm.hpp> // utx::iota
 #include <sycl/sycl.hpp>
 #include <boost/assert.hpp>
+#include "tensor-view.hpp"
+#include "trace.hpp"
 
 int main()
 {
-	sycl::queue queue{sycl::gpu_selector_v};
+	samples::trace::session trace; // SAMPLES_TRACE=three-dim-nd-lm.json writes a chrome trace
+	sycl::queue queue{sycl::gpu_selector_v, samples::trace::queue_properties()};
 	constexpr utx::uc32 ls0 = 2, ls1 = 2, ls2 = 2; // local range: 2x2x2
 	constexpr utx::uc32 gs0 = ls0*2, gs1 = ls1*2, gs2 = ls2*3; // global range: 4x4x6
 
@@ -27,7 +30,11 @@ int main()
 	auto src_buff = new sycl::buffer<utx::fc32, 3>{src.data(), sycl::range<3>{gs0, gs1, gs2}};
 	auto dst_buff = new sycl::buffer<utx::fc32, 3>{dst.data(), sycl::range<3>{gs0, gs1, gs2}};
 
-	queue.submit(
+	const auto range = sycl::nd_range<3>{
+		sycl::range<3>{gs0, gs1, gs2},
+		sycl::range<3>{ls0, ls1, ls2}
+	};
+	samples::trace::submit(queue, {"three_dim_nd_lm_kernel", range, 2.0*src.size()*sizeof(utx::fc32)},
 		[&] (sycl::handler & handler)
 		{
 			auto src_acc = sycl::accessor{*src_buff, handler, sycl::read_only};
@@ -38,10 +45,7 @@ int main()
 			//		and every group size is ls0 x ls1 x ls2, so every item can use 2 elements on local memory.
 			auto lm = sycl::local_accessor<utx::fc32, 3>{sycl::range<3>{ls0,ls1,ls2*count}, handler};
 			handler.parallel_for<class three_dim_nd_lm_kernel>(
-				sycl::nd_range<3>{
-					sycl::range<3>{gs0, gs1, gs2},
-					sycl::range<3>{ls0, ls1, ls2}
-				},
+				range,
 				[=, count=count()] (sycl::nd_item<3> item)
 				{
 					utx::uc32 gid0 = item.get_global_id(0);
@@ -83,13 +87,14 @@ int main()
 
 	auto print_three_dim = [&gs0, &gs1, &gs2] (const std::vector<utx::fc32> & vector)
 	{
+		const samples::tensor::view<const utx::fc32, 3> grid{vector.data(), sycl::range<3>{gs0, gs1, gs2}};
 		for (utx::uc32 k=0; k<gs0; k++)
 		{
 			for (utx::uc32 j=0; j<gs1; j++)
 			{
 				for (utx::uc32 i=0; i<gs2; i++)
 				{
-					utx::printnl(vector[k*gs1*gs2+j*gs2+i], "");
+					utx::printnl(grid(k, j, i), "");
 				}
 				utx::print();
 			}
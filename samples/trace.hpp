@@ -0,0 +1,286 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::trace: per-kernel tracing around queue::submit.
+//
+//	samples::trace::session trace; // first thing in main
+//	sycl::queue queue{sycl::gpu_selector_v, samples::trace::queue_properties()};
+//	samples::trace::submit(queue, {"kernel_vector_add", range, bytes}, [&] (sycl::handler & handler) { ... });
+//
+// Tracing is on when the SAMPLES_TRACE environment variable names an output file (or a
+// session is given one). Every traced submission then records the kernel name, its
+// global and local range, the bytes it accesses and its event. When the session ends, the
+// events are waited for and their command_submit/start/end timestamps are written as a
+// Chrome trace (chrome://tracing, ui.perfetto.dev), with a summary table on stderr.
+// Kernels of queues without enable_profiling only have a host clock submit time; they go
+// to their own process in the trace, with their own time origin.
+//
+// When tracing is off, submit is queue.submit behind one branch on a flag, and
+// launch holds no owning members, so nothing is allocated.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samples::trace
+{
+
+// what a traced submission launches
+struct launch
+{
+	const char * name = "kernel";
+	int dims = 0;
+	std::array<std::size_t, 3> global{};
+	std::array<std::size_t, 3> local{}; // 0 for a plain range
+	double bytes = 0; // global memory accessed
+
+	launch(const char * name, double bytes = 0):
+		name{name},
+		bytes{bytes}
+	{
+	}
+	template <int d>
+	launch(const char * name, const sycl::range<d> & global, double bytes = 0):
+		name{name},
+		dims{d},
+		bytes{bytes}
+	{
+		for (int i=0; i<d; i++)
+			this->global[i] = global[i];
+	}
+	template <int d>
+	launch(const char * name, const sycl::nd_range<d> & range, double bytes = 0):
+		name{name},
+		dims{d},
+		bytes{bytes}
+	{
+		for (int i=0; i<d; i++)
+		{
+			global[i] = range.get_global_range()[i];
+			local[i] = range.get_local_range()[i];
+		}
+	}
+};
+
+class recorder
+{
+private:
+	struct record
+	{
+		launch info;
+		std::string name;
+		sycl::event event;
+		std::int64_t host_submit; // ns, steady clock
+	};
+
+	bool on = false;
+	std::string path;
+	std::vector<record> records;
+	std::mutex mutex;
+
+	recorder()
+	{
+		if (const char * env = std::getenv("SAMPLES_TRACE"); env && *env)
+		{
+			on = true;
+			path = env;
+		}
+	}
+
+	static std::int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static std::string range_string(int dims, const std::array<std::size_t, 3> & values)
+	{
+		std::string text;
+		for (int i=0; i<dims; i++)
+			text += (i ? "x" : "") + std::to_string(values[i]);
+		return text;
+	}
+
+public:
+	static recorder & instance()
+	{
+		static recorder singleton;
+		return singleton;
+	}
+
+	bool enabled() const
+	{
+		return on;
+	}
+
+	void enable(std::string output)
+	{
+		std::lock_guard lock{mutex};
+		on = true;
+		path = std::move(output);
+	}
+
+	void add(const launch & info, const sycl::event & event)
+	{
+		const std::int64_t submitted = now();
+		std::lock_guard lock{mutex};
+		records.push_back({info, info.name, event, submitted});
+	}
+
+	// Waits for the recorded kernels, writes the trace and the summary, and starts over.
+	void flush()
+	{
+		std::lock_guard lock{mutex};
+		if (! on || records.empty())
+			return;
+
+		struct timing
+		{
+			std::int64_t submit, start, end;
+			bool profiled; // device clock, or host clock submit time only
+		};
+		std::vector<timing> times;
+		for (auto & r: records)
+		{
+			r.event.wait();
+			try
+			{
+				times.push_back({
+					static_cast<std::int64_t>(r.event.get_profiling_info<sycl::info::event_profiling::command_submit>()),
+					static_cast<std::int64_t>(r.event.get_profiling_info<sycl::info::event_profiling::command_start>()),
+					static_cast<std::int64_t>(r.event.get_profiling_info<sycl::info::event_profiling::command_end>()),
+					true
+				});
+			}
+			catch (const sycl::exception &)
+			{
+				// queue without enable_profiling: only the host submit time is known
+				times.push_back({r.host_submit, r.host_submit, r.host_submit, false});
+			}
+		}
+
+		// the two clocks are not comparable: pid 0 is the device clock, pid 1 the host clock
+		std::int64_t origin[2] = {INT64_MAX, INT64_MAX};
+		for (const auto & t: times)
+			origin[! t.profiled] = std::min(origin[! t.profiled], t.submit);
+		if (origin[1] != INT64_MAX)
+			std::cerr << "samples::trace: some queues have no enable_profiling, their kernels have no duration\n";
+
+		std::ofstream file{path, std::ios::trunc};
+		file << "{\"traceEvents\":[\n"
+			<< "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"device clock\"}},\n"
+			<< "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"host clock, no profiling\"}}";
+		for (std::size_t i=0; i<records.size(); i++)
+		{
+			const record & r = records[i];
+			const timing & t = times[i];
+			const int pid = ! t.profiled;
+			file << ",\n"
+				<< "{\"name\":\"" << json_escape(r.name) << "\",\"cat\":\"kernel\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":0"
+				<< ",\"ts\":" << (t.start-origin[pid])*1e-3 << ",\"dur\":" << (t.end-t.start)*1e-3
+				<< ",\"args\":{\"global\":\"" << range_string(r.info.dims, r.info.global)
+				<< "\",\"local\":\"" << range_string(r.info.local[0] ? r.info.dims : 0, r.info.local)
+				<< "\",\"bytes\":" << r.info.bytes
+				<< ",\"submit_us\":" << (t.submit-origin[pid])*1e-3
+				<< ",\"queued_us\":" << (t.start-t.submit)*1e-3 << "}}";
+		}
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		struct summary
+		{
+			std::size_t calls = 0;
+			double total_ms = 0, min_ms = 0, max_ms = 0, bytes = 0;
+		};
+		std::map<std::string, summary> table;
+		for (std::size_t i=0; i<records.size(); i++)
+		{
+			const double ms = (times[i].end-times[i].start)*1e-6;
+			summary & s = table[records[i].name];
+			s.min_ms = s.calls ? std::min(s.min_ms, ms) : ms;
+			s.max_ms = std::max(s.max_ms, ms);
+			s.total_ms += ms;
+			s.bytes += records[i].info.bytes;
+			s.calls++;
+		}
+		std::cerr << "samples::trace: " << records.size() << " kernels written to " << path << '\n'
+			<< std::left << std::setw(32) << "kernel" << std::right
+			<< std::setw(8) << "calls" << std::setw(12) << "total ms" << std::setw(12) << "mean ms"
+			<< std::setw(12) << "min ms" << std::setw(12) << "max ms" << std::setw(10) << "GB/s" << '\n';
+		for (const auto & [name, s]: table)
+			std::cerr << std::left << std::setw(32) << name << std::right
+				<< std::setw(8) << s.calls << std::setw(12) << s.total_ms << std::setw(12) << s.total_ms/s.calls
+				<< std::setw(12) << s.min_ms << std::setw(12) << s.max_ms
+				<< std::setw(10) << (s.total_ms > 0 ? s.bytes/s.total_ms*1e-6 : 0) << '\n';
+		records.clear();
+	}
+};
+
+inline bool enabled()
+{
+	return recorder::instance().enabled();
+}
+
+// enable_profiling when tracing is on, nothing otherwise
+inline sycl::property_list queue_properties()
+{
+	if (enabled())
+		return sycl::property_list{sycl::property::queue::enable_profiling{}};
+	return sycl::property_list{};
+}
+
+template <typename cgf_type>
+sycl::event submit(sycl::queue & queue, const launch & info, cgf_type && cgf)
+{
+	if (! enabled())
+		return queue.submit(std::forward<cgf_type>(cgf));
+	sycl::event event = queue.submit(std::forward<cgf_type>(cgf));
+	recorder::instance().add(info, event);
+	return event;
+}
+
+// Turns tracing on for the lifetime of the session when path is given (SAMPLES_TRACE
+// still works without it), and flushes the trace when the session ends.
+class session
+{
+public:
+	session() = default;
+	explicit session(std::string path)
+	{
+		recorder::instance().enable(std::move(path));
+	}
+	session(const session &) = delete;
+	session & operator=(const session &) = delete;
+	~session()
+	{
+		try
+		{
+			recorder::instance().flush();
+		}
+		catch (const std::exception & e)
+		{
+			std::cerr << "samples::trace: " << e.what() << '\n';
+		}
+	}
+};
+
+} // namespace samples::trace
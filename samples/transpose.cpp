@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Tiled transposes and layout conversions (see transpose.hpp) against a device memcpy
+// of the same bytes and a naive transpose with strided writes.
+//
+//	transpose --size=16777216 --warmup=2 --repeat=10 --format=csv
+//
+// The out-of-place runs use an n x (n+7) matrix with n*n close to --size, so the last
+// column of tiles is partial; the in-place runs use n x n. The elements are uc32 indices,
+// distinct for every size, so a misplaced element never compares equal.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "bench.hpp"
+#include "transpose.hpp"
+#include "usm-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class naive_transpose_kernel;
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t n = std::max<std::size_t>(static_cast<std::size_t>(std::sqrt(static_cast<double>(opts.size))), 1);
+	const std::size_t rows = n, cols = n+7, size = rows*cols;
+	const auto blocked = samples::matrix_layout::blocked(32);
+	const double bytes = 2.0*size*sizeof(utx::uc32);
+
+	std::vector<utx::uc32> host(size), result(blocked.size(rows, cols));
+	for (std::size_t i=0; i<size; i++)
+		host[i] = static_cast<std::uint32_t>(i);
+	auto a = samples::make_pooled<utx::uc32>(pool, size);
+	auto b = samples::make_pooled<utx::uc32>(pool, blocked.size(rows, cols));
+	auto c = samples::make_pooled<utx::uc32>(pool, size);
+	queue.memcpy(a.get(), host.data(), size*sizeof(utx::uc32)).wait();
+
+	// out holds the rows x cols matrix in layout
+	auto check = [&] (const std::string & name, const utx::uc32 * out, samples::matrix_layout layout,
+		std::size_t rows, std::size_t cols)
+	{
+		queue.memcpy(result.data(), out, layout.size(rows, cols)*sizeof(utx::uc32)).wait();
+		for (std::size_t r=0; r<rows; r++)
+			for (std::size_t c=0; c<cols; c++)
+				if (result[layout.offset(r, c, rows, cols)]() != host[r*cols+c]())
+				{
+					utx::printe(name, "FAILED at", r, c);
+					return false;
+				}
+		return true;
+	};
+	bool ok = true;
+
+	report(samples::bench::run(opts, "memcpy", "uc32", size, bytes, 0,
+		[&] { return queue.memcpy(c.get(), a.get(), size*sizeof(utx::uc32)); }));
+
+	const utx::uc32 * in = a.get();
+	utx::uc32 * out = c.get();
+	report(samples::bench::run(opts, "transpose-naive", "uc32", size, bytes, 0,
+		[&]
+		{
+			return queue.parallel_for<naive_transpose_kernel>(
+				sycl::range<2>{rows, cols},
+				[=] (sycl::id<2> id)
+				{
+					out[id[1]*rows + id[0]] = in[id[0]*cols + id[1]];
+				}
+			);
+		}
+	));
+	ok = check("transpose-naive", c.get(), samples::matrix_layout::column_major(), rows, cols) && ok;
+
+	report(samples::bench::run(opts, "transpose-tiled", "uc32", size, bytes, 0,
+		[&] { return samples::transpose(queue, a.get(), c.get(), rows, cols); }));
+	ok = check("transpose-tiled", c.get(), samples::matrix_layout::column_major(), rows, cols) && ok;
+
+	{
+		sycl::buffer<utx::uc32, 2> buffer_in{host.data(), sycl::range<2>{rows, cols}};
+		sycl::buffer<utx::uc32, 2> buffer_out{sycl::range<2>{cols, rows}};
+		report(samples::bench::run(opts, "transpose-tiled-buffer", "uc32", size, bytes, 0,
+			[&] { return samples::transpose(queue, buffer_in, buffer_out); }));
+		sycl::host_accessor acc{buffer_out, sycl::read_only};
+		for (std::size_t i=0; i<size; i++)
+			if (acc[i%cols][i/cols]() != host[i]())
+			{
+				utx::printe("transpose-tiled-buffer FAILED at", i/cols, i%cols);
+				ok = false;
+				break;
+			}
+	}
+
+	// row-major -> blocked -> column-major -> row-major
+	report(samples::bench::run(opts, "convert-row-blocked", "uc32", size, bytes, 0,
+		[&] { return samples::convert(queue, a.get(), samples::matrix_layout::row_major(), b.get(), blocked, rows, cols); }));
+	ok = check("convert-row-blocked", b.get(), blocked, rows, cols) && ok;
+	report(samples::bench::run(opts, "convert-blocked-column", "uc32", size, bytes, 0,
+		[&] { return samples::convert(queue, b.get(), blocked, c.get(), samples::matrix_layout::column_major(), rows, cols); }));
+	ok = check("convert-blocked-column", c.get(), samples::matrix_layout::column_major(), rows, cols) && ok;
+	report(samples::bench::run(opts, "convert-column-row", "uc32", size, bytes, 0,
+		[&] { return samples::convert(queue, c.get(), samples::matrix_layout::column_major(), b.get(), samples::matrix_layout::row_major(), rows, cols); }));
+	ok = check("convert-column-row", b.get(), samples::matrix_layout::row_major(), rows, cols) && ok;
+
+	// n x n in place; an even number of runs leaves the matrix as it was
+	const std::size_t square = n*n;
+	queue.memcpy(c.get(), host.data(), square*sizeof(utx::uc32)).wait();
+	samples::bench::options even = opts;
+	even.warmup += even.warmup%2;
+	even.repeat += even.repeat%2;
+	report(samples::bench::run(even, "transpose-in-place", "uc32", square, 2.0*square*sizeof(utx::uc32), 0,
+		[&] { return samples::transpose_in_place(queue, c.get(), n); }));
+	samples::transpose_in_place(queue, c.get(), n).wait();
+	queue.memcpy(result.data(), c.get(), square*sizeof(utx::uc32)).wait();
+	for (std::size_t i=0; i<square; i++)
+		if (result[(i%n)*n + i/n]() != host[i]())
+		{
+			utx::printe("transpose-in-place FAILED at", i/n, i%n);
+			ok = false;
+			break;
+		}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::transpose and samples::convert: tiled 2d transposes and layout conversions.
+//
+//	samples::transpose(queue, in, out);                  // sycl::buffer<T, 2>, out is cols x rows
+//	samples::transpose(queue, in, out, rows, cols);      // usm, row-major
+//	samples::transpose_in_place(queue, mat, n);          // usm or buffer, square
+//	samples::convert(queue, in, samples::matrix_layout::row_major(),
+//		out, samples::matrix_layout::blocked(32), rows, cols);
+//
+// A rows x cols matrix is stored row-major, column-major, or blocked: block x block tiles in
+// row-major tile order, every tile row-major, the edges padded up to whole tiles (the padding
+// is never written). Every work-group moves one 32 x 32 tile through local memory. It reads
+// the tile along the contiguous direction of the source layout and writes it along the
+// contiguous direction of the destination layout, so both global accesses are coalesced.
+// The tile has 33 columns, so a column of it hits 32 different local memory banks.
+// The row-major transpose of a matrix is its column-major copy, so transpose is a convert.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace samples
+{
+
+struct matrix_layout
+{
+	enum class kind
+	{
+		row_major,
+		column_major,
+		blocked,
+	};
+
+	kind order = kind::row_major;
+	std::size_t block = 32; // blocked only
+
+	static matrix_layout row_major()
+	{
+		return {kind::row_major};
+	}
+	static matrix_layout column_major()
+	{
+		return {kind::column_major};
+	}
+	static matrix_layout blocked(std::size_t block)
+	{
+		return {kind::blocked, block};
+	}
+
+	// elements to allocate for a rows x cols matrix
+	std::size_t size(std::size_t rows, std::size_t cols) const
+	{
+		return order == kind::blocked ? round_up(rows, block)*round_up(cols, block) : rows*cols;
+	}
+
+	std::size_t offset(std::size_t row, std::size_t col, std::size_t rows, std::size_t cols) const
+	{
+		if (order == kind::row_major)
+			return row*cols + col;
+		if (order == kind::column_major)
+			return col*rows + row;
+		const std::size_t tiles_per_row = (cols+block-1)/block;
+		return ((row/block)*tiles_per_row + col/block)*block*block + (row%block)*block + col%block;
+	}
+
+	// neighbouring columns are neighbouring addresses
+	bool rows_contiguous() const
+	{
+		return order != kind::column_major;
+	}
+};
+
+constexpr std::size_t transpose_tile = 32;
+constexpr std::size_t transpose_tile_rows = 8; // local range is 8 x 32, 4 elements per item
+
+template <typename data_type, bool usm>
+class convert_kernel;
+
+template <typename data_type, bool usm>
+class transpose_in_place_kernel;
+
+// the elements of a usm pointer or of an accessor in linear order
+template <typename data_type>
+data_type * linear_pointer(data_type * ptr)
+{
+	return ptr;
+}
+
+template <typename accessor_type>
+auto linear_pointer(const accessor_type & acc)
+{
+	return acc.template get_multi_ptr<sycl::access::decorated::no>().get();
+}
+
+// Enqueues the tiled conversion; src and dst are usm pointers or accessors.
+template <typename data_type, bool usm, typename src_type, typename dst_type>
+void convert_tiled(
+	sycl::handler & handler,
+	src_type src, matrix_layout from,
+	dst_type dst, matrix_layout to,
+	std::size_t rows, std::size_t cols
+)
+{
+	constexpr std::size_t tile = transpose_tile;
+	constexpr std::size_t tile_rows = transpose_tile_rows;
+	auto lm = sycl::local_accessor<data_type, 2>{sycl::range<2>{tile, tile+1}, handler};
+	handler.parallel_for<convert_kernel<data_type, usm>>(
+		sycl::nd_range<2>{
+			sycl::range<2>{round_up(rows, tile)/tile*tile_rows, round_up(cols, tile)},
+			sycl::range<2>{tile_rows, tile}
+		},
+		[=] (sycl::nd_item<2> item)
+		{
+			const std::size_t r0 = item.get_group(0)*tile, c0 = item.get_group(1)*tile;
+			const std::size_t ty = item.get_local_id(0), tx = item.get_local_id(1);
+			const auto in = linear_pointer(src);
+			const auto out = linear_pointer(dst);
+			for (std::size_t k=ty; k<tile; k+=tile_rows)
+			{
+				const std::size_t r = from.rows_contiguous() ? k : tx;
+				const std::size_t c = from.rows_contiguous() ? tx : k;
+				if (r0+r < rows && c0+c < cols)
+					lm[r][c] = in[from.offset(r0+r, c0+c, rows, cols)];
+			}
+			sycl::group_barrier(item.get_group());
+			for (std::size_t k=ty; k<tile; k+=tile_rows)
+			{
+				const std::size_t r = to.rows_contiguous() ? k : tx;
+				const std::size_t c = to.rows_contiguous() ? tx : k;
+				if (r0+r < rows && c0+c < cols)
+					out[to.offset(r0+r, c0+c, rows, cols)] = lm[r][c];
+			}
+		}
+	);
+}
+
+// out (in layout to) = in (in layout from), both rows x cols
+template <typename data_type>
+sycl::event convert(
+	sycl::queue & queue,
+	const data_type * in, matrix_layout from,
+	data_type * out, matrix_layout to,
+	std::size_t rows, std::size_t cols,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			convert_tiled<data_type, true>(handler, in, from, out, to, rows, cols);
+		}
+	);
+}
+
+// out = in^T; in is rows x cols, out is cols x rows, both row-major
+template <typename data_type>
+sycl::event transpose(
+	sycl::queue & queue,
+	const data_type * in, data_type * out,
+	std::size_t rows, std::size_t cols,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return convert(queue, in, matrix_layout::row_major(), out, matrix_layout::column_major(), rows, cols, deps);
+}
+
+template <typename data_type>
+sycl::event transpose(
+	sycl::queue & queue,
+	sycl::buffer<data_type, 2> & in,
+	sycl::buffer<data_type, 2> & out,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	const std::size_t rows = in.get_range()[0], cols = in.get_range()[1];
+	if (out.get_range()[0] != cols || out.get_range()[1] != rows)
+		throw std::invalid_argument{"samples::transpose: out must be cols x rows"};
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			auto acc_in = sycl::accessor{in, handler, sycl::read_only};
+			auto acc_out = sycl::accessor{out, handler, sycl::write_only, sycl::no_init};
+			convert_tiled<data_type, false>(handler, acc_in, matrix_layout::row_major(),
+				acc_out, matrix_layout::column_major(), rows, cols);
+		}
+	);
+}
+
+// Enqueues the in-place transpose of a row-major n x n matrix. The work-group of tile (bi, bj),
+// bi < bj, swaps it with tile (bj, bi) through two local tiles; the groups below the diagonal
+// have nothing to do.
+template <typename data_type, bool usm, typename mat_type>
+void transpose_in_place_tiled(sycl::handler & handler, mat_type mat, std::size_t n)
+{
+	constexpr std::size_t tile = transpose_tile;
+	constexpr std::size_t tile_rows = transpose_tile_rows;
+	auto lm_a = sycl::local_accessor<data_type, 2>{sycl::range<2>{tile, tile+1}, handler};
+	auto lm_b = sycl::local_accessor<data_type, 2>{sycl::range<2>{tile, tile+1}, handler};
+	const std::size_t tiles = (n+tile-1)/tile;
+	handler.parallel_for<transpose_in_place_kernel<data_type, usm>>(
+		sycl::nd_range<2>{
+			sycl::range<2>{tiles*tile_rows, tiles*tile},
+			sycl::range<2>{tile_rows, tile}
+		},
+		[=] (sycl::nd_item<2> item)
+		{
+			const std::size_t bi = item.get_group(0), bj = item.get_group(1);
+			if (bj < bi)
+				return; // the whole group leaves, before any barrier
+			const std::size_t r0 = bi*tile, c0 = bj*tile;
+			const std::size_t ty = item.get_local_id(0), tx = item.get_local_id(1);
+			const auto m = linear_pointer(mat);
+			for (std::size_t k=ty; k<tile; k+=tile_rows)
+			{
+				if (r0+k < n && c0+tx < n)
+					lm_a[k][tx] = m[(r0+k)*n + c0+tx];
+				if (bi != bj && c0+k < n && r0+tx < n)
+					lm_b[k][tx] = m[(c0+k)*n + r0+tx];
+			}
+			sycl::group_barrier(item.get_group());
+			for (std::size_t k=ty; k<tile; k+=tile_rows)
+			{
+				if (bi == bj)
+				{
+					if (r0+k < n && c0+tx < n)
+						m[(r0+k)*n + c0+tx] = lm_a[tx][k];
+					continue;
+				}
+				if (c0+k < n && r0+tx < n)
+					m[(c0+k)*n + r0+tx] = lm_a[tx][k];
+				if (r0+k < n && c0+tx < n)
+					m[(r0+k)*n + c0+tx] = lm_b[tx][k];
+			}
+		}
+	);
+}
+
+template <typename data_type>
+sycl::event transpose_in_place(
+	sycl::queue & queue,
+	data_type * mat, std::size_t n,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			transpose_in_place_tiled<data_type, true>(handler, mat, n);
+		}
+	);
+}
+
+template <typename data_type>
+sycl::event transpose_in_place(
+	sycl::queue & queue,
+	sycl::buffer<data_type, 2> & mat,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	const std::size_t n = mat.get_range()[0];
+	if (mat.get_range()[1] != n)
+		throw std::invalid_argument{"samples::transpose_in_place: the matrix must be square"};
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			auto acc = sycl::accessor{mat, handler, sycl::read_write};
+			transpose_in_place_tiled<data_type, false>(handler, acc, n);
+		}
+	);
+}
+
+} // namespace samples
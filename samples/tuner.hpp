@@ -0,0 +1,237 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Work-group size tuning.
+//
+//	samples::capabilities(device) queries the limits of every device (or sub-device) once
+//	per process.
+//	samples::tuner times candidate local ranges of one kernel and remembers the
+//	fastest one in a text file, one line per device and driver, kernel and global range:
+//		device/driver <tab> kernel <tab> g0 g1 g2 <tab> l0 l1 l2
+//	A later run finds the line and launches with it without searching again; a driver
+//	update tunes again.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include "common.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace samples
+{
+
+struct device_caps
+{
+	std::string name;
+	std::string driver_version;
+	std::size_t compute_units = 0;
+	std::size_t max_work_group_size = 0;
+	std::size_t max_work_item_size = 0; // smallest of the per-dimension limits
+	std::size_t local_mem_size = 0;
+	std::vector<std::size_t> sub_group_sizes;
+};
+
+inline const device_caps & capabilities(const sycl::device & device)
+{
+	static std::mutex mutex;
+	// keyed on the device itself: sub-devices share name and driver, not their limits
+	static std::unordered_map<sycl::device, device_caps> cache;
+
+	std::lock_guard lock{mutex};
+	if (auto iter = cache.find(device); iter != cache.end())
+		return iter->second;
+
+	device_caps caps;
+	caps.name = device.get_info<sycl::info::device::name>();
+	caps.driver_version = device.get_info<sycl::info::device::driver_version>();
+	caps.compute_units = device.get_info<sycl::info::device::max_compute_units>();
+	caps.max_work_group_size = device.get_info<sycl::info::device::max_work_group_size>();
+	const auto item_sizes = device.get_info<sycl::info::device::max_work_item_sizes<3>>();
+	caps.max_work_item_size = std::min({item_sizes[0], item_sizes[1], item_sizes[2]});
+	caps.local_mem_size = device.get_info<sycl::info::device::local_mem_size>();
+	caps.sub_group_sizes = device.get_info<sycl::info::device::sub_group_sizes>();
+	std::sort(caps.sub_group_sizes.begin(), caps.sub_group_sizes.end());
+	return cache.emplace(device, std::move(caps)).first->second;
+}
+
+// Local ranges that divide global exactly: power of two extents within the
+// device limits, whose size is a multiple of the smallest sub-group size.
+template <int dims>
+std::vector<sycl::range<dims>> local_candidates(
+	const device_caps & caps,
+	const sycl::range<dims> & global,
+	std::size_t max_candidates = 24
+)
+{
+	const std::size_t sub_group = caps.sub_group_sizes.empty() ? 1 : caps.sub_group_sizes.front();
+
+	std::vector<std::array<std::size_t, dims>> shapes, all;
+	std::array<std::size_t, dims> shape;
+	auto walk = [&] (auto & self, int dim, std::size_t total) -> void
+	{
+		if (dim == dims)
+		{
+			all.push_back(shape);
+			if (total%sub_group == 0)
+				shapes.push_back(shape);
+			return;
+		}
+		for (std::size_t extent=1; extent<=global[dim] && extent<=caps.max_work_item_size &&
+			total*extent<=caps.max_work_group_size; extent*=2)
+		{
+			if (global[dim]%extent != 0)
+				continue;
+			shape[dim] = extent;
+			self(self, dim+1, total*extent);
+		}
+	};
+	walk(walk, 0, 1);
+	if (shapes.empty())
+		shapes = std::move(all);
+
+	auto size_of = [] (const std::array<std::size_t, dims> & s)
+	{
+		std::size_t total = 1;
+		for (std::size_t x: s)
+			total *= x;
+		return total;
+	};
+	std::sort(shapes.begin(), shapes.end(),
+		[&] (const auto & a, const auto & b)
+		{
+			return size_of(a) != size_of(b) ? size_of(a) < size_of(b) : a < b;
+		}
+	);
+
+	// keep an evenly spaced subset, always including the largest shape
+	std::vector<sycl::range<dims>> result;
+	const std::size_t count = std::min(shapes.size(), max_candidates);
+	for (std::size_t i=0; i<count; i++)
+	{
+		const std::size_t pick = count == 1 ? shapes.size()-1 : i*(shapes.size()-1)/(count-1);
+		result.push_back(to_range<dims>(shapes[pick]));
+	}
+	return result;
+}
+
+class tuner
+{
+private:
+	std::string path;
+	std::map<std::string, std::string> entries; // key -> "l0 l1 l2"
+	std::size_t repeat;
+public:
+	explicit tuner(std::string path, std::size_t repeat=3):
+		path{std::move(path)},
+		repeat{repeat}
+	{
+		std::ifstream file{this->path};
+		std::string line;
+		while (std::getline(file, line))
+		{
+			const auto tab = line.rfind('\t');
+			if (tab != std::string::npos)
+				entries[line.substr(0, tab)] = line.substr(tab+1);
+		}
+	}
+
+	// launch(sycl::nd_range<dims>) submits the kernel and returns its event.
+	template <int dims, typename launch_type>
+	sycl::range<dims> tune(
+		sycl::queue & queue,
+		const std::string & kernel,
+		const sycl::range<dims> & global,
+		launch_type && launch
+	)
+	{
+		const std::string key = make_key(queue.get_device(), kernel, global);
+		if (auto iter = entries.find(key); iter != entries.end())
+		{
+			std::istringstream in{iter->second};
+			std::array<std::size_t, dims> local;
+			for (auto & extent: local)
+				in >> extent;
+			if (in)
+				return to_range<dims>(local);
+		}
+
+		const bool profiling = queue.has_property<sycl::property::queue::enable_profiling>();
+		const auto & caps = capabilities(queue.get_device());
+
+		double best_ms = std::numeric_limits<double>::max();
+		std::array<std::size_t, dims> ones;
+		ones.fill(1);
+		sycl::range<dims> best = to_range<dims>(ones); // the launch every device accepts
+		for (const auto & local: local_candidates<dims>(caps, global))
+		{
+			try
+			{
+				const sycl::nd_range<dims> range{global, local};
+				launch(range).wait(); // warm-up
+				double ms = std::numeric_limits<double>::max();
+				for (std::size_t i=0; i<repeat; i++)
+				{
+					const auto start = std::chrono::steady_clock::now();
+					sycl::event event = launch(range);
+					event.wait();
+					const double host_ms = std::chrono::duration<double, std::milli>(
+						std::chrono::steady_clock::now()-start).count();
+					ms = std::min(ms, profiling ? bench::kernel_ms(event) : host_ms);
+				}
+				if (ms < best_ms)
+				{
+					best_ms = ms;
+					best = local;
+				}
+			}
+			catch (const sycl::exception &)
+			{
+				// the kernel does not accept this local range (e.g. too much local memory)
+			}
+		}
+
+		std::ostringstream out;
+		for (int d=0; d<dims; d++)
+			out << (d ? " " : "") << best[d];
+		entries[key] = out.str();
+		save();
+		return best;
+	}
+
+	void save() const
+	{
+		std::ofstream file{path, std::ios::trunc};
+		for (const auto & [key, value]: entries)
+			file << key << '\t' << value << '\n';
+	}
+
+private:
+	template <int dims>
+	static std::string make_key(const sycl::device & device, const std::string & kernel, const sycl::range<dims> & global)
+	{
+		std::ostringstream out;
+		const device_caps & caps = capabilities(device);
+		out << caps.name << '/' << caps.driver_version << '\t' << kernel << '\t';
+		for (int d=0; d<dims; d++)
+			out << (d ? " " : "") << global[d];
+		return out.str();
+	}
+};
+
+} // namespace samples
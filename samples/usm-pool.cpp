@@ -0,0 +1,181 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// usm versions of the matrix-mul, smart-pointer, std-simd and three-dim-nd-lm kernels
+// on pooled device, shared and host allocations (see usm-pool.hpp).
+//
+//	usm-pool [runs]
+//
+// Every run takes its blocks from the pools and gives them back at the end, so only
+// the first run calls sycl::malloc. Copies are explicit queue.memcpy, there is no
+// buffer destructor writing back behind our back.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include <utxcpp/algorithm.hpp>
+#include <utxcpp/flat.hpp>
+#include <experimental/simd>
+#include "gemm.hpp"
+#include "usm-pool.hpp"
+#include <cstdlib>
+#include <numbers>
+
+namespace stdx = std::experimental;
+
+void print_pool(const char * name, const samples::usm_pool & pool)
+{
+	const auto stats = pool.stats();
+	utx::print(name, "requests:", stats.requests, "hits:", stats.hits, "hit rate:", stats.hit_rate(),
+		"sycl::malloc:", stats.runtime_allocations, "cached bytes:", stats.bytes_cached);
+}
+
+int main(int argc, char * argv[])
+{
+	sycl::queue queue{sycl::gpu_selector_v, sycl::property_list{sycl::property::queue::in_order{}}};
+	const std::size_t runs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100;
+
+	samples::usm_pool device_pool{queue, sycl::usm::alloc::device};
+	samples::usm_pool shared_pool{queue, sycl::usm::alloc::shared};
+	samples::usm_pool host_pool{queue, sycl::usm::alloc::host};
+
+	// matrix-mul inputs
+	constexpr std::size_t side = 4;
+	const std::vector<utx::ic32>
+		mat1 =
+			{
+				1,2,3,4,
+				3,2,1,4,
+				2,1,3,4,
+				4,3,1,2
+			},
+		mat2 =
+			{
+				1,1,2,1,
+				2,1,3,2,
+				3,3,1,4,
+				2,1,2,3
+			}
+	;
+
+	// std-simd inputs
+	using position_t = uflat::vector4uc32;
+	using position_simd = stdx::native_simd<utx::u32>;
+	constexpr std::size_t positions = 4*16;
+	constexpr std::size_t lanes = positions*4;
+	static_assert(lanes%position_simd::size() == 0);
+
+	// three-dim-nd-lm inputs
+	constexpr std::size_t gs0 = 4, gs1 = 4, gs2 = 6;
+	constexpr std::size_t volume = gs0*gs1*gs2;
+
+	std::size_t first_run_allocations = 0;
+	for (std::size_t run=0; run<runs; run++)
+	{
+		// matrix-mul: device memory, result staged in pinned host memory
+		auto a = samples::make_pooled<utx::ic32>(device_pool, side*side);
+		auto b = samples::make_pooled<utx::ic32>(device_pool, side*side);
+		auto c = samples::make_pooled<utx::ic32>(device_pool, side*side);
+		auto mat3 = samples::make_pooled<utx::ic32>(host_pool, side*side);
+		queue.memcpy(a.get(), mat1.data(), side*side*sizeof(utx::ic32));
+		queue.memcpy(b.get(), mat2.data(), side*side*sizeof(utx::ic32));
+		samples::gemm(queue, a.get(), b.get(), c.get(), side, side, side);
+		queue.memcpy(mat3.get(), c.get(), side*side*sizeof(utx::ic32));
+
+		// smart-pointer: shared memory, utx::sin in place
+		auto ptr = samples::make_pooled<utx::fc32>(shared_pool, 6*6);
+		for (utx::uc32 i=0; i<6*6; i++)
+			ptr[i] = -std::numbers::pi + i*std::numbers::pi/20;
+		queue.parallel_for<class usm_sin_kernel>(
+			sycl::range<2>{6, 6},
+			[ptr=ptr.get()] (sycl::id<2> id)
+			{
+				utx::fc32 & rw = ptr[id[0]*6+id[1]];
+				rw = utx::sin(rw);
+			}
+		);
+
+		// std-simd: device memory, one native_simd per item
+		auto map = samples::make_pooled<position_t>(host_pool, positions);
+		utx::iota(&map[0][0], &map[0][0]+lanes, 1);
+		auto map_dev = samples::make_pooled<utx::u32>(device_pool, lanes);
+		queue.memcpy(map_dev.get(), &map[0][0], lanes*sizeof(utx::u32));
+		queue.parallel_for<class usm_simd_kernel>(
+			sycl::range<1>{lanes/position_simd::size()},
+			[lane=map_dev.get()] (sycl::id<1> id)
+			{
+				utx::u32 * pos = lane + id[0]*position_simd::size();
+				position_simd simd;
+				simd.copy_from(pos, stdx::element_aligned);
+				simd *= simd;
+				simd.copy_to(pos, stdx::element_aligned);
+			}
+		);
+		queue.memcpy(&map[0][0], map_dev.get(), lanes*sizeof(utx::u32));
+
+		// three-dim-nd-lm: device memory, utx::sqrt from src to dst
+		auto src = samples::make_pooled<utx::fc32>(host_pool, volume);
+		utx::iota(src.get(), src.get()+volume, 1);
+		auto src_dev = samples::make_pooled<utx::fc32>(device_pool, volume);
+		auto dst_dev = samples::make_pooled<utx::fc32>(device_pool, volume);
+		auto dst = samples::make_pooled<utx::fc32>(host_pool, volume);
+		queue.memcpy(src_dev.get(), src.get(), volume*sizeof(utx::fc32));
+		queue.parallel_for<class usm_sqrt_kernel>(
+			sycl::range<3>{gs0, gs1, gs2},
+			[src=src_dev.get(), dst=dst_dev.get()] (sycl::id<3> id)
+			{
+				const std::size_t index = (id[0]*gs1+id[1])*gs2+id[2];
+				dst[index] = utx::sqrt(src[index]);
+			}
+		);
+		queue.memcpy(dst.get(), dst_dev.get(), volume*sizeof(utx::fc32));
+
+		queue.wait();
+
+		if (run == 0)
+		{
+			first_run_allocations =
+				device_pool.stats().runtime_allocations +
+				shared_pool.stats().runtime_allocations +
+				host_pool.stats().runtime_allocations;
+
+			utx::print("matrix-mul:");
+			for (std::size_t j=0; j<side; j++)
+			{
+				for (std::size_t i=0; i<side; i++)
+					utx::printnl(mat3[j*side+i], "");
+				utx::print();
+			}
+			utx::print("smart-pointer:");
+			for (std::size_t j=0; j<6; j++)
+			{
+				for (std::size_t i=0; i<6; i++)
+					utx::printnl(ptr[j*6+i], "");
+				utx::print();
+			}
+			utx::print("std-simd:");
+			for (std::size_t i=0; i<positions; i++)
+				utx::printnl('(', map[i][0], map[i][1], map[i][2], map[i][3], ")  ");
+			utx::print();
+			utx::print("three-dim-nd-lm:");
+			for (std::size_t i=0; i<volume; i++)
+				utx::printnl(dst[i], "");
+			utx::print();
+		}
+	}
+
+	print_pool("device pool", device_pool);
+	print_pool("shared pool", shared_pool);
+	print_pool("host pool  ", host_pool);
+
+	const std::size_t allocations =
+		device_pool.stats().runtime_allocations +
+		shared_pool.stats().runtime_allocations +
+		host_pool.stats().runtime_allocations;
+	utx::print("sycl::malloc calls after the first run:", allocations-first_run_allocations);
+	return allocations == first_run_allocations ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::usm_pool: caching allocator over sycl::malloc_device/shared/host.
+//
+//	Requests are rounded up to a power of two size class (at least 256 bytes).
+//	deallocate() keeps the block on the free list of its class, and the next
+//	request of that class takes it back without calling the sycl runtime.
+//	stats() tells how many requests were served from the free lists.
+//
+//	deallocate() does not know about the commands that use a block: the caller must make
+//	sure none is pending, or the next request of the class may hand the block to a new
+//	kernel while an old one still runs on an out-of-order queue (bench::make_queue).
+//	deallocate(block, event) waits for the last use first; samples::release_after gives
+//	the block back from a host_task after the last use, without blocking the host.
+//	pooled_ptr deallocates when it is destroyed, so wait for its users before that.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <bit>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace samples
+{
+
+class usm_pool
+{
+public:
+	struct statistics
+	{
+		std::size_t requests = 0;
+		std::size_t hits = 0; // requests served from the free lists
+		std::size_t runtime_allocations = 0; // calls of sycl::malloc
+		std::size_t runtime_frees = 0; // calls of sycl::free
+		std::size_t bytes_in_use = 0;
+		std::size_t bytes_cached = 0;
+
+		double hit_rate() const
+		{
+			return requests ? static_cast<double>(hits)/requests : 0.0;
+		}
+	};
+
+	static constexpr std::size_t min_block = 256;
+
+private:
+	sycl::queue queue;
+	sycl::usm::alloc kind;
+	std::map<std::size_t, std::vector<void *>> free_blocks; // size class -> blocks
+	std::unordered_map<void *, std::size_t> live_blocks; // block -> size class
+	statistics counters;
+	mutable std::mutex mutex;
+
+public:
+	usm_pool(const sycl::queue & queue, sycl::usm::alloc kind):
+		queue{queue},
+		kind{kind}
+	{
+	}
+	usm_pool(const usm_pool &) = delete;
+	usm_pool & operator=(const usm_pool &) = delete;
+	~usm_pool()
+	{
+		release();
+		for (auto & [block, size]: live_blocks)
+			sycl::free(block, queue);
+	}
+
+	static std::size_t size_class(std::size_t bytes)
+	{
+		return std::bit_ceil(bytes < min_block ? min_block : bytes);
+	}
+
+	void * allocate(std::size_t bytes)
+	{
+		const std::size_t size = size_class(bytes);
+		std::lock_guard lock{mutex};
+		counters.requests++;
+
+		void * block = nullptr;
+		auto & list = free_blocks[size];
+		if (! list.empty())
+		{
+			block = list.back();
+			list.pop_back();
+			counters.hits++;
+			counters.bytes_cached -= size;
+		}
+		else
+		{
+			block = sycl::malloc(size, queue, kind);
+			if (! block)
+				throw std::bad_alloc{};
+			counters.runtime_allocations++;
+		}
+		live_blocks.emplace(block, size);
+		counters.bytes_in_use += size;
+		return block;
+	}
+
+	template <typename data_type>
+	data_type * allocate(std::size_t count)
+	{
+		return static_cast<data_type *>(allocate(count*sizeof(data_type)));
+	}
+
+	// No pending command may still use block.
+	void deallocate(void * block)
+	{
+		if (! block)
+			return;
+		std::lock_guard lock{mutex};
+		auto iter = live_blocks.find(block);
+		if (iter == live_blocks.end())
+			throw std::invalid_argument{"samples::usm_pool: block is not from this pool"};
+		const std::size_t size = iter->second;
+		live_blocks.erase(iter);
+		free_blocks[size].push_back(block);
+		counters.bytes_in_use -= size;
+		counters.bytes_cached += size;
+	}
+
+	// Waits for last_use, the last command that uses block, then deallocates it.
+	void deallocate(void * block, const sycl::event & last_use)
+	{
+		sycl::event{last_use}.wait();
+		deallocate(block);
+	}
+
+	// Returns the cached blocks to the sycl runtime.
+	void release()
+	{
+		std::lock_guard lock{mutex};
+		for (auto & [size, list]: free_blocks)
+		{
+			for (void * block: list)
+			{
+				sycl::free(block, queue);
+				counters.runtime_frees++;
+			}
+			list.clear();
+		}
+		counters.bytes_cached = 0;
+	}
+
+	statistics stats() const
+	{
+		std::lock_guard lock{mutex};
+		return counters;
+	}
+
+	sycl::usm::alloc get_kind() const
+	{
+		return kind;
+	}
+};
+
+// Gives block back to the pool once event has completed, without blocking the host.
+inline void release_after(sycl::queue & queue, usm_pool & pool, void * block, const sycl::event & event)
+{
+	queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(event);
+			handler.host_task(
+				[pool=&pool, block]
+				{
+					pool->deallocate(block);
+				}
+			);
+		}
+	);
+}
+
+// unique_ptr that gives its block back to the pool when it is destroyed; no pending
+// command may still use the block then.
+struct usm_pool_deleter
+{
+	usm_pool * pool;
+
+	void operator()(void * block) const
+	{
+		pool->deallocate(block);
+	}
+};
+
+template <typename data_type>
+using pooled_ptr = std::unique_ptr<data_type[], usm_pool_deleter>;
+
+template <typename data_type>
+pooled_ptr<data_type> make_pooled(usm_pool & pool, std::size_t count)
+{
+	return pooled_ptr<data_type>{pool.allocate<data_type>(count), usm_pool_deleter{&pool}};
+}
+
+} // namespace samples
@@ -0,0 +1,186 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// sqrt, sin, cos and cbrt on sycl::vec<float, 4/8/16> (see vec-math.hpp) against one
+// scalar utx function call per work-item, as in sycl-local-memory and smart-pointer.
+//
+//	vec-math --size=16777216 --warmup=2 --repeat=10 --format=csv
+//
+// 13 elements are added to --size so every width has a tail. For every variant the max
+// error in ulp against a double precision host result, and the max distance in ulp from
+// the scalar utx result, go to stderr.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include "bench.hpp"
+#include "usm-pool.hpp"
+#include "vec-math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vec_math = samples::vec_math;
+
+template <typename op_type>
+class scalar_kernel;
+
+struct host_math
+{
+	static double apply(vec_math::sqrt_op, double x)
+	{
+		return std::sqrt(x);
+	}
+	static double apply(vec_math::sin_op, double x)
+	{
+		return std::sin(x);
+	}
+	static double apply(vec_math::cos_op, double x)
+	{
+		return std::cos(x);
+	}
+	static double apply(vec_math::cbrt_op, double x)
+	{
+		return std::cbrt(x);
+	}
+};
+
+struct utx_math
+{
+	static utx::fc32 apply(vec_math::sqrt_op, utx::fc32 x)
+	{
+		return utx::sqrt(x);
+	}
+	static utx::fc32 apply(vec_math::sin_op, utx::fc32 x)
+	{
+		return utx::sin(x);
+	}
+	static utx::fc32 apply(vec_math::cos_op, utx::fc32 x)
+	{
+		return utx::cos(x);
+	}
+	static utx::fc32 apply(vec_math::cbrt_op, utx::fc32 x)
+	{
+		return utx::cbrt(x);
+	}
+};
+
+// distance of got from want in units of the last place of want as a float
+double ulp(float got, double want)
+{
+	const float rounded = static_cast<float>(want);
+	const float unit = std::nextafter(std::abs(rounded), std::numeric_limits<float>::infinity()) - std::abs(rounded);
+	return std::abs(got - want)/std::max(unit, std::numeric_limits<float>::denorm_min());
+}
+
+class runner
+{
+private:
+	sycl::queue & queue;
+	const samples::bench::options & opts;
+	samples::bench::reporter & report;
+	std::size_t size;
+	const utx::fc32 * in;
+	utx::fc32 * out;
+	std::vector<utx::fc32> host_in, host_out, scalar_out;
+
+	void errors(const std::string & label, const std::vector<double> & want)
+	{
+		queue.memcpy(host_out.data(), out, size*sizeof(utx::fc32)).wait();
+		double max_ulp = 0, max_scalar = 0;
+		for (std::size_t i=0; i<size; i++)
+		{
+			max_ulp = std::max(max_ulp, ulp(host_out[i](), want[i]));
+			max_scalar = std::max(max_scalar, ulp(host_out[i](), scalar_out[i]()));
+		}
+		utx::printe(label, "max ulp:", max_ulp, "max ulp from utx:", max_scalar);
+	}
+
+	template <typename op_type, int width, vec_math::precision p>
+	void run_vec(const std::vector<double> & want)
+	{
+		const std::string label = std::string{"vec-"} + op_type::name + "-" + std::to_string(width) + "-" + vec_math::name(p);
+		report(samples::bench::run(opts, label, "fc32", size, 2.0*size*sizeof(utx::fc32), size,
+			[&] { return vec_math::apply<op_type, width, p>(queue, in, out, size); }));
+		errors(label, want);
+	}
+
+public:
+	runner(sycl::queue & queue, const samples::bench::options & opts, samples::bench::reporter & report,
+		std::size_t size, const utx::fc32 * in, utx::fc32 * out, std::vector<utx::fc32> host_in):
+		queue{queue},
+		opts{opts},
+		report{report},
+		size{size},
+		in{in},
+		out{out},
+		host_in{std::move(host_in)},
+		host_out(size),
+		scalar_out(size)
+	{
+	}
+
+	template <typename op_type>
+	void operator()(op_type op)
+	{
+		std::vector<double> want(size);
+		for (std::size_t i=0; i<size; i++)
+			want[i] = host_math::apply(op, host_in[i]());
+
+		const std::string label = std::string{"scalar-utx-"} + op_type::name;
+		const utx::fc32 * src = in;
+		utx::fc32 * dst = out;
+		report(samples::bench::run(opts, label, "fc32", size, 2.0*size*sizeof(utx::fc32), size,
+			[&]
+			{
+				return queue.parallel_for<scalar_kernel<op_type>>(
+					sycl::range<1>{size},
+					[=] (sycl::id<1> id)
+					{
+						dst[id] = utx_math::apply(op_type{}, src[id]);
+					}
+				);
+			}
+		));
+		queue.memcpy(scalar_out.data(), out, size*sizeof(utx::fc32)).wait();
+		errors(label, want);
+
+		run_vec<op_type, 4, vec_math::precision::full>(want);
+		run_vec<op_type, 8, vec_math::precision::full>(want);
+		run_vec<op_type, 16, vec_math::precision::full>(want);
+		run_vec<op_type, 8, vec_math::precision::native>(want);
+		run_vec<op_type, 16, vec_math::precision::native>(want);
+		run_vec<op_type, 8, vec_math::precision::half>(want);
+		run_vec<op_type, 16, vec_math::precision::half>(want);
+	}
+};
+
+int main(int argc, char * argv[])
+{
+	const auto opts = samples::bench::parse_options(argc, argv);
+	sycl::queue queue = samples::bench::make_queue();
+	samples::bench::reporter report{opts, queue};
+	samples::usm_pool pool{queue, sycl::usm::alloc::device};
+
+	const std::size_t size = opts.size + 13;
+	std::vector<utx::fc32> host_in(size);
+	for (std::size_t i=0; i<size; i++)
+		host_in[i] = static_cast<float>(i%10000)/100.0f; // [0, 100)
+	auto in = samples::make_pooled<utx::fc32>(pool, size);
+	auto out = samples::make_pooled<utx::fc32>(pool, size);
+	queue.memcpy(in.get(), host_in.data(), size*sizeof(utx::fc32)).wait();
+
+	runner run{queue, opts, report, size, in.get(), out.get(), host_in};
+	run(vec_math::sqrt_op{});
+	run(vec_math::sin_op{});
+	run(vec_math::cos_op{});
+	run(vec_math::cbrt_op{});
+	return 0;
+}
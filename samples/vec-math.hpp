@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// samples::vec_math: elementwise sqrt, sin, cos and cbrt on sycl::vec<float, width>.
+//
+//	samples::vec_math::apply<samples::vec_math::sin_op, 8>(queue, in, out, size);
+//	samples::vec_math::apply<samples::vec_math::sin_op, 8, samples::vec_math::precision::native>(...);
+//
+// Every work-item loads, computes and stores one vec of width lanes (4, 8 or 16), so the
+// math maps onto the vector units of cpu backends. The size % width elements of the tail
+// are one scalar work-item each, in the same launch. precision::native (sycl::native::)
+// and precision::half (sycl::half_precision::) trade accuracy for speed and are only used
+// when asked for; functions without such variants (cbrt) stay at full precision.
+
+#pragma once
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include "common.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace samples::vec_math
+{
+
+enum class precision
+{
+	full,
+	native,
+	half,
+};
+
+constexpr const char * name(precision p)
+{
+	return p == precision::full ? "full" : p == precision::native ? "native" : "half";
+}
+
+struct sqrt_op
+{
+	static constexpr const char * name = "sqrt";
+	template <precision p, typename value_type>
+	static value_type apply(value_type x)
+	{
+		if constexpr (p == precision::native)
+			return sycl::native::sqrt(x);
+		else if constexpr (p == precision::half)
+			return sycl::half_precision::sqrt(x);
+		else
+			return sycl::sqrt(x);
+	}
+};
+
+struct sin_op
+{
+	static constexpr const char * name = "sin";
+	template <precision p, typename value_type>
+	static value_type apply(value_type x)
+	{
+		if constexpr (p == precision::native)
+			return sycl::native::sin(x);
+		else if constexpr (p == precision::half)
+			return sycl::half_precision::sin(x);
+		else
+			return sycl::sin(x);
+	}
+};
+
+struct cos_op
+{
+	static constexpr const char * name = "cos";
+	template <precision p, typename value_type>
+	static value_type apply(value_type x)
+	{
+		if constexpr (p == precision::native)
+			return sycl::native::cos(x);
+		else if constexpr (p == precision::half)
+			return sycl::half_precision::cos(x);
+		else
+			return sycl::cos(x);
+	}
+};
+
+struct cbrt_op
+{
+	static constexpr const char * name = "cbrt";
+	template <precision p, typename value_type>
+	static value_type apply(value_type x)
+	{
+		return sycl::cbrt(x);
+	}
+};
+
+template <typename op_type, int width, precision p>
+class vec_math_kernel;
+
+// out[i] = op(in[i]) for i in [0, size)
+template <typename op_type, int width, precision p=precision::full>
+sycl::event apply(
+	sycl::queue & queue,
+	const utx::fc32 * in, utx::fc32 * out, std::size_t size,
+	const std::vector<sycl::event> & deps = {}
+)
+{
+	static_assert(width == 1 || width == 2 || width == 4 || width == 8 || width == 16);
+	using vec_type = sycl::vec<float, width>;
+	const std::size_t vectors = size/width;
+	const std::size_t tail = size%width;
+	const float * src = raw_pointer(in);
+	float * dst = raw_pointer(out);
+	return queue.submit(
+		[&] (sycl::handler & handler)
+		{
+			handler.depends_on(deps);
+			handler.parallel_for<vec_math_kernel<op_type, width, p>>(
+				sycl::range<1>{vectors+tail},
+				[=] (sycl::id<1> id)
+				{
+					const std::size_t i = id[0];
+					if (i < vectors)
+					{
+						auto global_src = sycl::address_space_cast<sycl::access::address_space::global_space,
+							sycl::access::decorated::no>(src);
+						auto global_dst = sycl::address_space_cast<sycl::access::address_space::global_space,
+							sycl::access::decorated::no>(dst);
+						vec_type v;
+						v.load(i, global_src);
+						v = op_type::template apply<p>(v);
+						v.store(i, global_dst);
+					}
+					else
+					{
+						const std::size_t e = vectors*width + (i-vectors);
+						dst[e] = op_type::template apply<p>(src[e]);
+					}
+				}
+			);
+		}
+	);
+}
+
+} // namespace samples::vec_math
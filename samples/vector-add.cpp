@@ -8,10 +8,12 @@
 #include <sycl/sycl.hpp>
 #include <utxcpp/core.hpp>
 #include <utxcpp/algorithm.hpp>
+#include "trace.hpp"
 
 int main()
 {
-	sycl::queue queue{sycl::gpu_selector_v};
+	samples::trace::session trace; // SAMPLES_TRACE=vector-add.json writes a chrome trace
+	sycl::queue queue{sycl::gpu_selector_v, samples::trace::queue_properties()};
 
 	constexpr utx::uc32 gsize = 9;
 	constexpr utx::uc32 lsize = 3;
@@ -25,17 +27,18 @@ int main()
 	auto buff2 = sycl::buffer<utx::ic32, 1>{add2};
 	auto buff3 = sycl::buffer<utx::ic32, 1>{result};
 	
-	queue.submit(
+	const auto range = sycl::nd_range<1>{
+		sycl::range<1>{gsize},
+		sycl::range<1>{lsize}
+	};
+	samples::trace::submit(queue, {"kernel_vector_add", range, 3.0*gsize()*sizeof(utx::ic32)},
 		[&] (sycl::handler & handler)
 		{
 			auto acc1 = buff1.get_access<sycl::access_mode::read>(handler);
 			auto acc2 = buff2.get_access<sycl::access_mode::read>(handler);
 			auto acc3 = buff3.get_access<sycl::access_mode::write>(handler);
 			handler.parallel_for<class kernel_vector_add>(
-				sycl::nd_range<1>{
-					sycl::range<1>{gsize},
-					sycl::range<1>{lsize}
-				},
+				range,
 				[=] (sycl::nd_item<1> item)
 				{
 					utx::uc32 gid = item.get_global_id();
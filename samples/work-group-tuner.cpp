@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2023 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Work-group size tuning (see tuner.hpp).
+//
+//	work-group-tuner [cache-file]
+//
+// The first run times candidate local ranges of the vector-add, 2d sqrt and 3d sqrt
+// kernels and saves the fastest ones; later runs read them from the cache file.
+
+#include <sycl/sycl.hpp>
+#include <utxcpp/core.hpp>
+#include <utxcpp/math.hpp>
+#include <utxcpp/algorithm.hpp>
+#include "bench.hpp"
+#include "tuner.hpp"
+
+int main(int argc, char * argv[])
+{
+	sycl::queue queue = samples::bench::make_queue();
+
+	const auto & caps = samples::capabilities(queue.get_device());
+	utx::print("device:", caps.name);
+	utx::print("compute units:", caps.compute_units);
+	utx::print("max work-group size:", caps.max_work_group_size);
+	utx::print("max work-item size:", caps.max_work_item_size);
+	utx::print("local memory size:", caps.local_mem_size);
+	utx::printnl("sub-group sizes:");
+	for (std::size_t size: caps.sub_group_sizes)
+		utx::printnl(size);
+	utx::print();
+
+	samples::tuner tuner{argc > 1 ? argv[1] : "work-group-tuner.txt"};
+
+	// vector-add
+	{
+		constexpr std::size_t gsize = std::size_t{1} << 24;
+		std::vector<utx::ic32> add1(gsize), add2(gsize), result(gsize);
+		utx::iota(add1, 1);
+		utx::iota(add2, 37);
+		sycl::buffer<utx::ic32, 1> buff1{add1}, buff2{add2}, buff3{result};
+		const auto local = tuner.tune(queue, "vector-add", sycl::range<1>{gsize},
+			[&] (const sycl::nd_range<1> & range)
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto acc1 = buff1.get_access<sycl::access_mode::read>(handler);
+						auto acc2 = buff2.get_access<sycl::access_mode::read>(handler);
+						auto acc3 = buff3.get_access<sycl::access_mode::write>(handler);
+						handler.parallel_for<class tuned_vector_add>(
+							range,
+							[=] (sycl::nd_item<1> item)
+							{
+								utx::uc32 gid = item.get_global_id();
+								acc3[gid()] = acc1[gid()] + acc2[gid()];
+							}
+						);
+					}
+				);
+			}
+		);
+		utx::print("vector-add", gsize, "local range:", local[0]);
+	}
+
+	// sqrt on a 2d range
+	{
+		constexpr std::size_t gsize = 4096;
+		std::vector<utx::fc32> vector(gsize*gsize, 2.0f);
+		sycl::buffer<utx::fc32, 2> buffer{vector.data(), sycl::range<2>{gsize, gsize}};
+		const auto local = tuner.tune(queue, "sqrt-2d", sycl::range<2>{gsize, gsize},
+			[&] (const sycl::nd_range<2> & range)
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto acc = buffer.get_access<sycl::access_mode::read_write>(handler);
+						handler.parallel_for<class tuned_sqrt_2d>(
+							range,
+							[=] (sycl::nd_item<2> item)
+							{
+								utx::fc32 & gm = acc[item.get_global_id()];
+								gm = utx::sqrt(gm);
+							}
+						);
+					}
+				);
+			}
+		);
+		utx::print("sqrt-2d", gsize, 'x', gsize, "local range:", local[0], 'x', local[1]);
+	}
+
+	// sqrt on a 3d range
+	{
+		constexpr std::size_t gsize = 256;
+		std::vector<utx::fc32> vector(gsize*gsize*gsize, 2.0f);
+		sycl::buffer<utx::fc32, 3> buffer{vector.data(), sycl::range<3>{gsize, gsize, gsize}};
+		const auto local = tuner.tune(queue, "sqrt-3d", sycl::range<3>{gsize, gsize, gsize},
+			[&] (const sycl::nd_range<3> & range)
+			{
+				return queue.submit(
+					[&] (sycl::handler & handler)
+					{
+						auto acc = buffer.get_access<sycl::access_mode::read_write>(handler);
+						handler.parallel_for<class tuned_sqrt_3d>(
+							range,
+							[=] (sycl::nd_item<3> item)
+							{
+								utx::fc32 & gm = acc[item.get_global_id()];
+								gm = utx::sqrt(gm);
+							}
+						);
+					}
+				);
+			}
+		);
+		utx::print("sqrt-3d", gsize, 'x', gsize, 'x', gsize, "local range:", local[0], 'x', local[1], 'x', local[2]);
+	}
+}